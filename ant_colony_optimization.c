@@ -5,8 +5,8 @@
  *
  */
 
-#include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -15,6 +15,7 @@
 #include "local_search.h"
 #include "node.h"
 #include "problemreader.h"
+#include "rng.h"
 #include "route.h"
 #include "solution.h"
 #include "vrptwms.h"
@@ -26,16 +27,52 @@
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
 
+// renormalize the stored pheromone once evaporation falls below this factor
+static const double MIN_PHEROMONE_SCALE = 1e-100;
+
+//! Guards the problem's attempts and state during parallel construction;
+//! these are shared by all ants of a generation.
+static pthread_mutex_t attempts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//! Data shared by the threads constructing the ants of a generation.
+typedef struct colony {
+  Problem* pb;
+  int workers;
+  Solution_Filter filter;  //!< Optional; NULL to keep all ants.
+  State_Filter ls_filter;  //!< Optional; see do_ls_filtered.
+  void* data;  //!< Passed to the filters.
+  int num_threads;
+  int stop;  //!< Set by the main thread to end the worker threads.
+  pthread_barrier_t start;  //!< Passed when a generation starts.
+  pthread_barrier_t done;  //!< Passed when a generation is complete.
+} Colony;
+
+//! A thread constructing its share of each generation's ants.
+//! Aligned to a cache line as the threads are stored next to each other.
+typedef struct ant_thread {
+  pthread_t thread;
+  Colony* colony;
+  int index;
+  Rng rng;  //!< The thread's own random number generator.
+  Move_Evaluator* evaluator;  //!< The thread's own evaluator.
+  Solution* sol;  //!< Scratch solution the ants are constructed in.
+  Solution* best;  //!< The thread's best ant of the current generation.
+  double best_cost;
+} __attribute__ ((aligned (64))) Ant_Thread;
+
+static void add_pheromone(Problem* pb, int i, int j, double amount);
 static int calc_aco_insertion(Route *, Node *, Insertion *);
 static int calc_mr_insertion(Route *, Node *, Insertion *);
-static Insertion *calc_next_insertion(Route *, Node *n, Node *after);
-static double calc_trail(double** p_m, int depot_id, int pred_id, int succ_id,
-                         int node_id);
+static Insertion *calc_next_insertion(Route *, Node *n, int *pos);
+static double calc_trail(const Problem* pb, int depot_id, int pred_id,
+                         int succ_id, int node_id);
 static Node* get_parallel_seed(Solution*);
 static Insertion* init_parallel_insertions(Solution*);
 static void init_parallel_routes(Solution*, int workers);
+static Insertion* pick_parallel_insertion(Insertion* insertions, Rng* rng);
 static Insertion* prepend_insertions(Insertion *, Route *, Node *)
   __attribute__ ((warn_unused_result));
+static void* run_ants(void* ant_thread);
 static void solve_parallel_aco(Solution* sol, int workers);
 static void solve_solomon_aco(Solution*, int workers);
 static void solve_solomon_mr(Solution*, int workers);
@@ -44,9 +81,16 @@ static Insertion* update_insertions(Insertion* old, Insertion* ins,
   __attribute__ ((warn_unused_result));
 
 
+//! Add the given amount to the (evaporated) pheromone on the arc from i to j.
+static void add_pheromone(Problem* pb, int i, int j, double amount) {
+  pb->pheromone[i][j] = (get_pheromone(pb, i, j) + amount) /
+                        pb->pheromone_scale;
+}
+
+
 //! Pick one of the given insertions using a weighted roulette wheel mechanism.
 Insertion* aco_pick_insertion(Insertion insertions[],
-                              int num_insertions, double min_cost) {
+                              int num_insertions, double min_cost, Rng* rng) {
   double cum_attractiveness = 0.0;
   Insertion* ins = (Insertion*) NULL;
   double threshold = 0.0;
@@ -57,7 +101,7 @@ Insertion* aco_pick_insertion(Insertion insertions[],
                                         min_cost);
     cum_attractiveness += insertions[i].attractiveness;
   }
-  threshold = drand48() * cum_attractiveness;
+  threshold = rand_uniform(rng) * cum_attractiveness;
   for (int i = 0; i < num_insertions; ++i) {
     cum_attractiveness -= insertions[i].attractiveness;
     if (threshold >= cum_attractiveness) {
@@ -76,46 +120,45 @@ Insertion* aco_pick_insertion(Insertion insertions[],
 //! \param route The route on which the given node is to be inserted.
 //! \return 1 if at least one position is possible, 0 otherwise.
 static int calc_aco_insertion(Route *route, Node *node, Insertion *ins) {
-  Node* after = route->nodes;
+  const Route_Array* a = &route->arr;
   double cost_dist = 0.0, cost_time = 0.0, cost = 0.0;
   double est_node = 0.0, est_succ = 0.0;
-  double** d = route->pb->c_m[0]; // distance
-  double** c_m = route->pb->c_m[route->workers];
+  const Problem* pb = route->pb;
+  int workers = route->workers;
   double alpha = route->pb->cfg->alpha, alpha2 = 1.0 - alpha;
   double mu = route->pb->cfg->mu;
   double lambda = route->pb->cfg->lambda;
-  double** p_m = route->pb->pheromone;
   double trail = 1.0;
   int updated = 0;
 
-  if (route->pb->capacity < route->load + node->demand)
+  if (route->pb->inst->capacity < route->load + node->demand)
     return 0;
-  while (after != route->tail) {
-    if (!can_insert_one(route, node, after)) {
-      after = after->next;
+  for (int i = 0; i < route->len - 1; ++i) {  // insert after node i
+    if (!is_granular_position(route, node, i) ||
+        !can_insert_at(route, node, i))
       continue;
-    }
-    cost_dist = d[after->id][node->id] + d[node->id][after->next->id] -
-    mu * d[after->id][after->next->id];
+    int pred = a->ids[i], succ = a->ids[i + 1];
+    cost_dist = get_dist(pb, pred, node->id) +
+    get_dist(pb, node->id, succ) -
+    mu * get_dist(pb, pred, succ);
     if (alpha2) {
-      est_node = max(node->est, after->aest + c_m[after->id][node->id]);
-      est_succ = max(after->next->aest, est_node +
-                     c_m[node->id][after->next->id]);
-      cost_time = est_succ - after->next->aest;
+      est_node = max(node->est, a->aest[i] +
+                     get_cost(pb, workers, pred, node->id));
+      est_succ = max(a->aest[i + 1], est_node +
+                     get_cost(pb, workers, node->id, succ));
+      cost_time = est_succ - a->aest[i + 1];
     }
     cost = alpha * cost_dist + alpha2 * cost_time;
-    cost = cost - lambda * d[DEPOT][node->id];
-    trail = calc_trail(p_m, route->depot_id, after->id, after->next->id,
-                       node->id);
+    cost = cost - lambda * get_dist(pb, DEPOT, node->id);
+    trail = calc_trail(pb, route->depot_id, pred, succ, node->id);
     cost = (cost >= 0) ? (cost / trail) : (cost * trail);
     if (cost < ins->cost) {
       ins->target = route;
       ins->node = node;
-      ins->after = after;
+      ins->after = a->nodes[i];
       ins->cost = cost;
       updated = 1;
     }
-    after = after->next;
   }
   return updated;
 }
@@ -123,92 +166,100 @@ static int calc_aco_insertion(Route *route, Node *node, Insertion *ins) {
 
 // TODO: document and compare to _aco_ version
 static int calc_mr_insertion(Route* route, Node* node, Insertion* ins) {
-  Node* after = route->nodes;
+  const Route_Array* a = &route->arr;
   double cost_dist = 0.0, cost_time = 0.0, cost = 0.0, attract = 0.0;
   double est_node = 0.0, est_succ = 0.0;
-  double** d = route->pb->c_m[0];  // distance matrix
-  double** c_m = route->pb->c_m[route->workers];
+  const Problem* pb = route->pb;
+  int workers = route->workers;
   double alpha = route->pb->cfg->alpha, alpha2 = 1.0 - alpha;
   double mu = route->pb->cfg->mu;
   double lambda = route->pb->cfg->lambda;
-  double** p_m = route->pb->pheromone;
   double trail = 1.0;
   int updated = 0;
 
-  if (route->pb->capacity < route->load + node->demand)
+  if (route->pb->inst->capacity < route->load + node->demand)
     return 0;
-  while (after != route->tail) {
-    if (!can_insert_one(route, node, after)) {
-      after = after->next;
+  for (int i = 0; i < route->len - 1; ++i) {  // insert after node i
+    if (!is_granular_position(route, node, i) ||
+        !can_insert_at(route, node, i))
       continue;
-    }
-    cost_dist = d[after->id][node->id] + d[node->id][after->next->id] -
-    mu * d[after->id][after->next->id];
+    int pred = a->ids[i], succ = a->ids[i + 1];
+    cost_dist = get_dist(pb, pred, node->id) +
+    get_dist(pb, node->id, succ) -
+    mu * get_dist(pb, pred, succ);
     if (alpha2) {
-      est_node = max(node->est, after->aest + c_m[after->id][node->id]);
-      est_succ = max(after->next->aest, est_node +
-      c_m[node->id][after->next->id]);
-      cost_time = est_succ - after->next->aest;
+      est_node = max(node->est, a->aest[i] +
+                     get_cost(pb, workers, pred, node->id));
+      est_succ = max(a->aest[i + 1], est_node +
+      get_cost(pb, workers, node->id, succ));
+      cost_time = est_succ - a->aest[i + 1];
     }
     cost = alpha * cost_dist + alpha2 * cost_time;
-    attract = lambda * d[DEPOT][node->id] - cost;
-    trail = calc_trail(p_m, route->depot_id, after->id, after->next->id,
-                       node->id);
+    attract = lambda * get_dist(pb, DEPOT, node->id) - cost;
+    trail = calc_trail(pb, route->depot_id, pred, succ, node->id);
     if (attract < 0.0)
       attract = MIN_DELTA;
     attract *= trail;
     if (attract > ins->attractiveness) {
       ins->target = route;
       ins->node = node;
-      ins->after = after;
+      ins->after = a->nodes[i];
       ins->attractiveness = attract;
       updated = 1;
     }
-    after = after->next;
   }
   return updated;
 }
 
 
-//! Return the first possible insertion position of n behind after.
+//! Return the first possible insertion of n after the node at position *pos
+//! or behind it.
 //! If there is no feasible position, return NULL.
 //! \param route The target route (n is attempted to be inserted into it).
-static Insertion *calc_next_insertion(Route *route, Node *n, Node *after) {
-  double **d = route->pb->c_m[0]; // distance matrix
-  double **c_m = route->pb->c_m[route->workers];
+//! \param pos The first position to try; set to the found position.
+static Insertion *calc_next_insertion(Route *route, Node *n, int *pos) {
+  const Problem *pb = route->pb;
+  const Route_Array *a = &route->arr;
+  int workers = route->workers;
   double cost_dist = 0.0, cost_time = 0.0, cost = 0.0;
   double est_node = 0.0, est_succ = 0.0;
   double trail = 1.0;
-  double **p_m = route->pb->pheromone;
   Insertion *ins = (Insertion *) NULL;
   double alpha = route->pb->cfg->alpha, alpha2 = 1 - alpha;
-  if (route->pb->capacity < route->load + n->demand)
+  if (route->pb->inst->capacity < route->load + n->demand)
     return (Insertion *) NULL;
-  while (!can_insert_one(route, n, after)) {
-    if (after->next == route->tail)
+  int i = *pos;
+  while (!is_granular_position(route, n, i) ||
+         !can_insert_at(route, n, i)) {
+    if (i + 1 == route->len - 1)  // the successor is the closing depot
       return (Insertion *) NULL;
-    after = after->next;
+    i++;
   }
+  *pos = i;
+  int pred = a->ids[i], succ = a->ids[i + 1];
   ins = (Insertion *) s_malloc(sizeof(Insertion));
   // own (non-solomon) attractiveness calculation
   // reasoning: distance from the depot doesn't play a role for the insertion
   // (saving) cost b/c there will not be a truck for just this customer
-  cost_dist = d[after->id][n->id] + d[n->id][after->next->id] -
-  route->pb->cfg->mu * d[after->id][after->next->id];
+  cost_dist = get_dist(pb, pred, n->id) +
+  get_dist(pb, n->id, succ) -
+  route->pb->cfg->mu * get_dist(pb, pred, succ);
   if (alpha2) {
-    est_node = max(n->est, after->aest + c_m[after->id][n->id]);
-    est_succ = max(after->next->aest, est_node + c_m[n->id][after->next->id]);
-    cost_time = est_succ - after->next->aest;
+    est_node = max(n->est, a->aest[i] +
+                   get_cost(pb, workers, pred, n->id));
+    est_succ = max(a->aest[i + 1], est_node +
+                   get_cost(pb, workers, n->id, succ));
+    cost_time = est_succ - a->aest[i + 1];
   }
   cost = alpha * cost_dist + alpha2 * cost_time;
-  trail = calc_trail(p_m, route->depot_id, after->id, after->next->id, n->id);
+  trail = calc_trail(pb, route->depot_id, pred, succ, n->id);
   if (cost > MIN_COST)
     ins->attractiveness = trail / cost;
   else
     ins->attractiveness = trail / MIN_COST;
   ins->cost = -1.0;
   ins->node = n;
-  ins->after = after;
+  ins->after = a->nodes[i];
   ins->target = route;
   ins->prev = (Insertion *) NULL;
   ins->next = (Insertion *) NULL;
@@ -221,14 +272,15 @@ static Insertion *calc_next_insertion(Route *route, Node *n, Node *after) {
 //! The pheromone would not work if all depot's had the same id. Hence,
 //! virtual depots are added to the pheromone after the last regular
 //! node - one for each route. A route's id serves as its depot id.
-static inline double calc_trail(double** p_m, int depot_id, int after_id,
-                                int succ_id, int node_id) {
+static inline double calc_trail(const Problem* pb, int depot_id,
+                                int after_id, int succ_id, int node_id) {
   if (after_id == DEPOT)
     after_id = depot_id;
   if (succ_id == DEPOT)
     succ_id = depot_id;
-  return (p_m[after_id][node_id] + p_m[node_id][succ_id]) /
-         (2.0 * p_m[after_id][succ_id]);
+  return (get_pheromone(pb, after_id, node_id) +
+          get_pheromone(pb, node_id, succ_id)) /
+         (2.0 * get_pheromone(pb, after_id, succ_id));
 }
 
 
@@ -240,22 +292,22 @@ static inline double calc_trail(double** p_m, int depot_id, int after_id,
 //! Return NULL if there are no candidates available.
 static Node* get_parallel_seed(Solution* sol) {
   Node *nl = sol->unrouted;
-  double **p_m = sol->pb->pheromone;
+  const Problem *pb = sol->pb;
   double cum_attractiveness = 0.0;
   double threshold = 0.0;
-  int num_nodes = sol->pb->num_nodes;
+  int depot_id = sol->pb->inst->num_nodes + sol->trucks;
   double trail[sol->num_unrouted];
   double* trail_ptr = trail;
   while (nl) {
-    (*trail_ptr) = (p_m[num_nodes + sol->trucks][nl->id] +
-                    p_m[nl->id][num_nodes + sol->trucks]);
+    (*trail_ptr) = (get_pheromone(pb, depot_id, nl->id) +
+                    get_pheromone(pb, nl->id, depot_id));
     cum_attractiveness += (*trail_ptr);
     trail_ptr++;
     nl = nl->next;
   }
   nl = sol->unrouted;
   trail_ptr = trail;
-  threshold = drand48() * cum_attractiveness;
+  threshold = rand_uniform(sol->rng) * cum_attractiveness;
   while (nl) {
     cum_attractiveness -= (*trail_ptr);
     if (threshold >= cum_attractiveness) return nl;
@@ -292,11 +344,14 @@ static void init_parallel_routes(Solution *sol, int workers) {
   Problem *pb = sol->pb;
   int max_trucks = pb->sol->trucks;  // best (min) known number of trucks
   if (!max_trucks) {  // there was no past solution
-    solve_solomon(pb->sol, workers, pb->num_nodes); // initialize truck number
+    // initialize truck number
+    solve_solomon(pb->sol, workers, pb->inst->num_nodes);
     max_trucks = pb->sol->trucks;
   }
+  pthread_mutex_lock(&attempts_lock);
   if (pb->state == REDUCE_TRUCKS)
     max_trucks--;
+  pthread_mutex_unlock(&attempts_lock);
   for (int i = 0; i < max_trucks; ++i) {
     unrouted = get_parallel_seed(sol);
     remove_unrouted(sol, unrouted);
@@ -305,30 +360,84 @@ static void init_parallel_routes(Solution *sol, int workers) {
 }
 
 
+//! Pick one of the given (linked) insertions by a weighted roulette wheel.
+//! All attractivenesses have to be positive.
+static Insertion* pick_parallel_insertion(Insertion* insertions, Rng* rng) {
+  double cum_attractiveness = 0.0;
+  for (Insertion* ins = insertions; ins; ins = ins->next) {
+    cum_attractiveness += ins->attractiveness;
+  }
+  double threshold = rand_uniform(rng) * cum_attractiveness;
+  for (Insertion* ins = insertions; ins; ins = ins->next) {
+    cum_attractiveness -= ins->attractiveness;
+    if (threshold >= cum_attractiveness) return ins;
+  }
+  fprintf(stderr, "ERROR: pick_parallel_insertion: no insertion picked\n");
+  exit(EXIT_FAILURE);
+}
+
+
 //! Prepending all possible insertions of n to r.
 //! \return new head of the insertion list
 // research result: only adding the best position like in I1 worsens the
 // overall solution quality even more in comparison to I1
 static Insertion* prepend_insertions(Insertion *ins, Route *r, Node *n) {
   Insertion *head = (Insertion *) NULL;
-  Node *after = r->nodes;
-  while (after != r->tail) {
-    head = calc_next_insertion(r, n, after);
+  int pos = 0;  // insert after the opening depot
+  while (pos < r->len - 1) {
+    head = calc_next_insertion(r, n, &pos);
     if (!head) break;
+    pos++;
     if (!ins) {
       ins = head;
-      after = head->after->next;
       continue;
     }
     ins->prev = head;
     head->next = ins;
     ins = head;
-    after = head->after->next;
   }
   return ins;
 }
 
 
+//! Construct and improve the thread's share of ants in each generation.
+//! Each generation starts when the main thread passes the start barrier and
+//! ends at the done barrier; in between, the pheromone is only read. The
+//! best ant of the generation is kept in the thread's best solution.
+static void* run_ants(void* ant_thread) {
+  Ant_Thread* at = (Ant_Thread*) ant_thread;
+  Colony* colony = at->colony;
+  const Problem* pb = colony->pb;
+  long ants = pb->ants / colony->num_threads +
+              (at->index < pb->ants % colony->num_threads);
+  while (1) {
+    pthread_barrier_wait(&colony->start);
+    if (colony->stop)
+      break;
+    at->best_cost = INFINITY;
+    for (long i = 0; i < ants; ++i) {
+      at->sol->rng = &at->rng;  // the solutions are swapped with other threads
+      at->sol->evaluator = at->evaluator;
+      reset_solution(at->sol, pb->inst->num_nodes);
+      aco_construct_routes(at->sol, colony->workers);
+      if (colony->filter && colony->filter(at->sol, colony->data))
+        continue;
+      if (do_ls_filtered(at->sol, colony->ls_filter, colony->data))
+        continue;
+      double cost = calc_costs(at->sol, pb->cfg);
+      if (cost < at->best_cost) {
+        Solution* temp = at->best;
+        at->best_cost = cost;
+        at->best = at->sol;
+        at->sol = temp;
+      }
+    }
+    pthread_barrier_wait(&colony->done);
+  }
+  return NULL;
+}
+
+
 //! Construct a solution's routes in parallel.
 //! Given an initial truck number in pb->sol->trucks all routes are constructed
 //! in parallel thus increasing the degree of freedom.
@@ -341,18 +450,14 @@ static void solve_parallel_aco(Solution *sol, int workers) {
   init_parallel_routes(sol, workers);
   Insertion *insertions = init_parallel_insertions(sol);
   while (insertions) {
-    // hack :(
-    ins = pick_insertion(&(Insertion_List) {.head = insertions,
-                                            .tail = (Insertion*) NULL,
-                                            .size = 0,
-                                            .max_size = LONG_MAX},
-                         USE_WEIGHTS);
+    ins = pick_parallel_insertion(insertions, sol->rng);
     remove_unrouted(sol, ins->node);
     add_nodes(ins->target, ins->node, ins->node, ins->after);
     insertions = update_insertions(insertions, ins, sol->unrouted);
   }
   // TODO: deal with remaining unrouted nodes (shake to move to
   // feasible solution) (meanwhile simply add them via solomon)
+  pthread_mutex_lock(&attempts_lock);
   if (!sol->unrouted) {
     sol->pb->attempts = 0;
   } else {
@@ -363,6 +468,7 @@ static void solve_parallel_aco(Solution *sol, int workers) {
     sol->pb->attempts = 0;
       }
   }
+  pthread_mutex_unlock(&attempts_lock);
   solve_solomon_aco(sol, workers);
 }
 
@@ -401,7 +507,8 @@ static void solve_solomon_aco(Solution *sol, int workers) {
         unrouted = unrouted->next;
       }
       if (isinf(min_cost)) break;
-      ins = *aco_pick_insertion(insertions, sol->num_unrouted, min_cost);
+      ins = *aco_pick_insertion(insertions, sol->num_unrouted, min_cost,
+                                sol->rng);
       remove_unrouted(sol, ins.node);
       add_nodes(ins.target, ins.node, ins.node, ins.after);
       ins.node = (Node *) NULL;
@@ -447,7 +554,8 @@ static void solve_solomon_mr(Solution *sol, int workers) {
         unrouted = unrouted->next;
       }
       if (isinf(max_attr)) break;
-      ins = *pick_insertion_from_array(insertions, sol->num_unrouted);
+      ins = *pick_insertion_from_array(insertions, sol->num_unrouted,
+                                       sol->rng);
       remove_unrouted(sol, ins.node);
       add_nodes(ins.target, ins.node, ins.node, ins.after);
       ins.node = (Node*) NULL;
@@ -505,13 +613,18 @@ void aco_construct_routes(Solution* sol, int workers) {
 //! of the routes in the solution. In our case this is done by a virtual depot
 //! id.
 void solve_aco(Problem* pb, int workers) {
+  if (pb->cfg->threads > 1) {
+    solve_aco_threaded(pb, workers, (Solution_Filter) NULL,
+                       (State_Filter) NULL, NULL);
+    return;
+  }
   double best_cost = INFINITY;
   double cost = INFINITY;
   Solution* sol = new_solution(pb);
   Solution* temp = NULL;
   while (proceed(pb, (unsigned long) pb->num_solutions)) {
-    for (int i = 0; i < pb->cfg->ants; ++i) {  // solve once for each ant
-      reset_solution(sol, pb->num_nodes);
+    for (int i = 0; i < pb->ants; ++i) {  // solve once for each ant
+      reset_solution(sol, pb->inst->num_nodes);
       aco_construct_routes(sol, workers);
 
       // TODO: calculate a hash, look if it's stored in a binary
@@ -530,13 +643,80 @@ void solve_aco(Problem* pb, int workers) {
         sol = temp;
       }
     }
-    pb->num_solutions += pb->cfg->ants;
+    pb->num_solutions += pb->ants;
     update_pheromone(pb, pb->sol);
   }
   free_solution(sol);
 }
 
 
+//! Solve the given problem using the ACO metaheuristic with several threads.
+//! The ants of each generation are distributed over cfg->threads threads
+//! which construct and improve them concurrently. Once all ants are done,
+//! the best one is determined (in the order of the threads for identical
+//! costs) before the pheromone is updated. The threads' generators are
+//! non-overlapping streams derived from the problem's generator.
+//! \param filter Optional; allows discarding ants before their local search.
+//!        It is called concurrently and has to synchronize itself.
+//! \param ls_filter Optional; allows abandoning the local search of ants that
+//!        reach known states (see do_ls_filtered). Called concurrently, too.
+//! \param data Passed to the filters.
+void solve_aco_threaded(Problem* pb, int workers, Solution_Filter filter,
+                        State_Filter ls_filter, void* data) {
+  double best_cost = INFINITY;
+  int num_threads = (int) pb->cfg->threads;
+  Colony colony = {.pb = pb, .workers = workers, .filter = filter,
+    .ls_filter = ls_filter, .data = data, .num_threads = num_threads,
+    .stop = 0};
+  Ant_Thread threads[num_threads];
+  Rng stream = pb->rng;
+  if (pb->cfg->start_heuristic == PARALLEL && !pb->sol->trucks) {
+    // see init_parallel_routes
+    solve_solomon(pb->sol, workers, pb->inst->num_nodes);
+  }
+  pthread_barrier_init(&colony.start, NULL, (unsigned) num_threads + 1);
+  pthread_barrier_init(&colony.done, NULL, (unsigned) num_threads + 1);
+  for (int t = 0; t < num_threads; ++t) {
+    jump_rng(&stream);
+    threads[t] = (Ant_Thread) {.colony = &colony, .index = t, .rng = stream,
+      .evaluator = new_move_evaluator(pb), .sol = new_solution(pb),
+      .best = new_solution(pb), .best_cost = INFINITY};
+    if (pthread_create(&threads[t].thread, NULL, run_ants, &threads[t])) {
+      fprintf(stderr, "ERROR: solve_aco_threaded: can't create thread\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  while (proceed(pb, (unsigned long) pb->num_solutions)) {
+    pthread_barrier_wait(&colony.start);
+    pthread_barrier_wait(&colony.done);
+    for (int t = 0; t < num_threads; ++t) {
+      if (threads[t].best_cost < best_cost) {
+        Solution* temp = pb->sol;
+        best_cost = threads[t].best_cost;
+        pb->sol = threads[t].best;
+        threads[t].best = temp;
+        pb->sol->time = time((time_t *)NULL) - pb->start_time;
+        print_progress(pb->sol);
+      }
+    }
+    pb->num_solutions += pb->ants;
+    update_pheromone(pb, pb->sol);
+  }
+  colony.stop = 1;
+  pthread_barrier_wait(&colony.start);
+  for (int t = 0; t < num_threads; ++t) {
+    pthread_join(threads[t].thread, NULL);
+    free_solution(threads[t].sol);
+    free_solution(threads[t].best);
+    free_move_evaluator(threads[t].evaluator);
+  }
+  pb->sol->rng = &pb->rng;
+  pb->sol->evaluator = pb->evaluator;
+  pthread_barrier_destroy(&colony.start);
+  pthread_barrier_destroy(&colony.done);
+}
+
+
 // TODO: implement adaptive fast aco; if successful give proper name
 //! Solve the given problem using the ACO metaheuristic.
 //! The way the pheromone between the depot nodes and the regular nodes is
@@ -551,12 +731,12 @@ void solve_gaco(Problem* pb, int workers) {
   Solution* sol = new_solution(pb);
   Solution* temp = NULL;
   while (proceed(pb, (unsigned long) pb->num_solutions)) {
-    for (int i = 0; i < pb->cfg->ants; ++i) {  // solve once for each ant
+    for (int i = 0; i < pb->ants; ++i) {  // solve once for each ant
       aco_construct_routes(sol, workers);
 
       // TODO: if the aco is stuck, add long term memory to avoid same
       // solution areas
-      if (drand48() >= 0.0) {
+      if (rand_uniform(sol->rng) >= 0.0) {
         sol = do_ls(sol);
       } else {
         for (int i = 0; i < sol->trucks; ++i) {
@@ -580,9 +760,7 @@ void solve_gaco(Problem* pb, int workers) {
         local_best_cost = cost;
         print_progress(sol);  // TODO: maybe remove
 //         } else {
-        set_double_matrix(pb->pheromone, (size_t) (2 * pb->num_nodes - 1),
-                          (size_t) (2 * pb->num_nodes - 1),
-                          pb->cfg->initial_pheromone);
+        set_pheromone(pb, pb->cfg->initial_pheromone);
         local_best_cost = INFINITY;
 //         }
       } else if (fabs(local_best_cost - cost) < 0.001) {
@@ -598,9 +776,9 @@ void solve_gaco(Problem* pb, int workers) {
         pb->sol = sol;
         sol = temp;
       }
-      reset_solution(sol, pb->num_nodes);
+      reset_solution(sol, pb->inst->num_nodes);
     }
-    pb->num_solutions += pb->cfg->ants;
+    pb->num_solutions += pb->ants;
     update_pheromone(pb, pb->sol);
   }
   free_solution(sol);
@@ -611,6 +789,10 @@ void solve_gaco(Problem* pb, int workers) {
 //! The persistance is determined by a constant factor \rho and the
 //! reinforcement is (1 - persistance) for all nodes i having j as a
 //! successor in the given solution, otherwise 0.
+//! The evaporation is not applied to the whole matrix. Instead, the global
+//! pheromone_scale is multiplied by \rho and min_pheromone is enforced when
+//! reading (see get_pheromone). Only the reinforced arcs are written. Once
+//! the scale becomes tiny, the stored values are renormalized.
 //! The size of the pheromone matrix is (2n+1)x(2n+1) where n is the number of
 //! customers not including the depot. Technically, (2n)x(2n) would suffice,
 //! but the first row and column are ignored to avoid indexing errors (this
@@ -642,21 +824,27 @@ void solve_gaco(Problem* pb, int workers) {
 //!     depot), col denotes id of virtual closing depot
 void update_pheromone(Problem *pb, Solution *sol) {
   Node* n = (Node*) NULL;
-  double** p_m = pb->pheromone;
-  double rho = pb->cfg->rho, min_pheromone = pb->cfg->min_pheromone;
+  double rho = pb->cfg->rho;
   double new_pheromone = 1.0 - rho;
-  int num_nodes = pb->num_nodes;
-  for (int i = 1; i < (2 * num_nodes - 1); ++i) {  // ignore 0 DEPOT
-    for (int j = 1; j < (2 * num_nodes - 1); ++j) {
-      p_m[i][j] = max(p_m[i][j] * rho, min_pheromone);
+  int num_nodes = pb->inst->num_nodes;
+  pb->pheromone_scale *= rho;  // evaporate
+  pb->pheromone_floor = pb->cfg->min_pheromone;
+  if (pb->pheromone_scale < MIN_PHEROMONE_SCALE) {
+    for (int i = 1; i < (2 * num_nodes - 1); ++i) {  // ignore 0 DEPOT
+      for (int j = 1; j < (2 * num_nodes - 1); ++j) {
+        pb->pheromone[i][j] = get_pheromone(pb, i, j);
+      }
     }
+    pb->pheromone_scale = 1.0;
   }
   for (int r = 0; r < sol->trucks; ++r) {
-    p_m[num_nodes + r][sol->routes[r]->nodes->next->id] += new_pheromone;
-    p_m[sol->routes[r]->tail->prev->id][num_nodes + r] += new_pheromone;
+    add_pheromone(pb, num_nodes + r, sol->routes[r]->nodes->next->id,
+                  new_pheromone);
+    add_pheromone(pb, sol->routes[r]->tail->prev->id, num_nodes + r,
+                  new_pheromone);
     n = sol->routes[r]->nodes->next->next;  // ignore the starting depot node
     while (n->next) {  // ignore the ending depot node
-      p_m[n->prev->id][n->id] += new_pheromone;
+      add_pheromone(pb, n->prev->id, n->id, new_pheromone);
       n = n->next;
     }
   }
@@ -664,6 +852,7 @@ void update_pheromone(Problem *pb, Solution *sol) {
   if (pb->cfg->verbosity >= FULL_DEBUG) {
     printf("\n");
     fprint_solution(stdout, sol, pb->cfg, 1);
+    printf("pheromone scale: %g\n", pb->pheromone_scale);
     print_double_matrix(2 * num_nodes - 1, pb->pheromone, "pheromone");
   }
   #endif
@@ -13,9 +13,14 @@
 // TODO: move aco_pick_insertion to private when vrptwms::solve_solomon
 // is updated; import of route becomes obsolete then :)
 #include "route.h"
+#include "solution.h"  // for Solution_Filter and State_Filter
+
 void aco_construct_routes(Solution* sol, int workers);
-Insertion* aco_pick_insertion(Insertion[], int num_insertions, double min_cost);
+Insertion* aco_pick_insertion(Insertion[], int num_insertions, double min_cost,
+                              Rng*);
 void solve_aco(Problem*, int workers);
+void solve_aco_threaded(Problem*, int workers, Solution_Filter filter,
+                        State_Filter ls_filter, void* data);
 void solve_gaco(Problem*, int workers);
 void update_pheromone(Problem*, Solution*);
 
@@ -5,9 +5,8 @@
  *
  */
 
-#include <cmath>
+#include <algorithm>
 #include <iostream>
-#include <limits>
 
 extern "C" {
   #include "solution.h"
@@ -16,9 +15,53 @@ extern "C" {
 #include "cache.hpp"
 
 
-Cache::Cache(const Problem& pb) : m_cfg(*(pb.cfg))
+static const int INITIAL_BITS = 10;  // the table starts with 1024 slots
+static const int MIN_BITS = 4;
+static const std::size_t SLOT_BYTES = sizeof(std::uint64_t) +
+  sizeof(std::uint32_t);
+
+
+/**
+ * Return the number of bits addressing the largest table within the budget.
+ *
+ * While the table grows, the old and the doubled table are both allocated;
+ * the budget includes this transient. The table has at least 2^MIN_BITS
+ * slots, even if the budget is smaller.
+ */
+static int max_bits(long int max_bytes)
 {
-  m_factor = std::numeric_limits<unsigned long int>::max() / pb.num_nodes;
+  int bits(MIN_BITS);
+  std::size_t budget(static_cast<std::size_t>(max_bytes));
+  budget = budget > sizeof(Cache) ? budget - sizeof(Cache) : 0;
+  while (bits < 62 && (std::size_t(3) << bits) * SLOT_BYTES <= budget)
+    bits++;
+  return bits;
+}
+
+
+/**
+ * Create an empty cache bounded by cache_max_bytes and cache_max_entries.
+ *
+ * \param shares The number of caches splitting the configured budget; each
+ *        of them is bounded by its share.
+ */
+Cache::Cache(const Problem& pb, long int shares)
+  : m_size(0), m_max_size(SIZE_MAX), m_hand(0), m_adds(0), m_lookups(0),
+    m_hits(0), m_evictions(0), m_cfg(*(pb.cfg))
+{
+  int bits(INITIAL_BITS);
+  if (m_cfg.cache_max_bytes > 0) {
+    int limit(max_bits(std::max(m_cfg.cache_max_bytes / shares, 1L)));
+    bits = std::min(bits, limit);
+    m_max_size = 3 * (std::size_t(1) << limit) / 4;
+  }
+  if (m_cfg.cache_max_entries > 0) {
+    long int max_entries(std::max(m_cfg.cache_max_entries / shares, 1L));
+    m_max_size = std::min(m_max_size, static_cast<std::size_t>(max_entries));
+  }
+  m_keys.resize(std::size_t(1) << bits);
+  m_counts.resize(std::size_t(1) << bits);
+  m_shift = 64 - bits;
 }
 
 
@@ -31,7 +74,31 @@ Cache::Cache(const Problem& pb) : m_cfg(*(pb.cfg))
  */
 void Cache::add(const Solution& s)
 {
-  m_cache[hash(s)] = 1;
+  add_key(hash(s));
+}
+
+
+/**
+ * Add the key to the table and set its counter to 1 (see add).
+ *
+ * If the table is full, another key is evicted first.
+ */
+void Cache::add_key(std::uint64_t key)
+{
+  std::size_t slot(find(key));
+  m_adds++;
+  if (!m_counts[slot]) {
+    if (m_size >= m_max_size) {
+      evict();
+      slot = find(key);
+    } else if (4 * (m_size + 1) > 3 * m_keys.size()) {
+      grow();
+      slot = find(key);
+    }
+    m_keys[slot] = key;
+    m_size++;
+  }
+  m_counts[slot] = 1;
 }
 
 
@@ -42,13 +109,166 @@ void Cache::add(const Solution& s)
  */
 unsigned long int Cache::contains(const Solution& s)
 {
-  unsigned long int hash_value = hash(s);
-  auto pair = m_cache.find(hash_value);
-  if (pair != m_cache.end()) {
-    pair->second++;
-    return pair->second;
+  return count_key(hash(s));
+}
+
+
+/**
+ * Return the incremented counter of the key or 0 if it is not in the table.
+ *
+ * The counters saturate instead of wrapping around.
+ */
+unsigned long int Cache::count_key(std::uint64_t key)
+{
+  std::size_t slot(find(key));
+  m_lookups++;
+  if (m_counts[slot]) {
+    m_hits++;
+    if (m_counts[slot] < UINT32_MAX)
+      m_counts[slot]++;
+  }
+  return m_counts[slot];
+}
+
+
+/**
+ * Remove the key in the given slot from the table.
+ *
+ * The following keys of the probe sequence are shifted back to close the gap
+ * (no tombstones are needed).
+ */
+void Cache::erase(std::size_t slot)
+{
+  std::size_t mask(m_keys.size() - 1);
+  std::size_t next((slot + 1) & mask);
+  while (m_counts[next]) {
+    // the key at next may fill the gap unless its home is after the gap
+    if (((next - home(m_keys[next])) & mask) >= ((next - slot) & mask)) {
+      m_keys[slot] = m_keys[next];
+      m_counts[slot] = m_counts[next];
+      slot = next;
+    }
+    next = (next + 1) & mask;
   }
-  return 0;
+  m_counts[slot] = 0;
+  m_size--;
+}
+
+
+/**
+ * Evict a key following the CLOCK policy.
+ *
+ * The hand halves the counters of the keys it passes; the first key whose
+ * counter is 1 (ie. it was not encountered again since it was added or
+ * last passed) is evicted. Terminates as every pass halves the counters.
+ */
+void Cache::evict()
+{
+  std::size_t mask(m_keys.size() - 1);
+  while (true) {
+    std::size_t slot(m_hand);
+    m_hand = (m_hand + 1) & mask;
+    if (m_counts[slot] > 1) {
+      m_counts[slot] /= 2;
+    } else if (m_counts[slot]) {
+      erase(slot);
+      m_evictions++;
+      return;
+    }
+  }
+}
+
+
+/**
+ * Return the number of keys evicted to respect the cache's bounds.
+ */
+unsigned long int Cache::evictions() const
+{
+  return m_evictions;
+}
+
+
+/**
+ * Return the slot holding the key or the empty slot it would be stored in.
+ *
+ * Collisions are resolved by linear probing starting at the key's home slot.
+ */
+std::size_t Cache::find(std::uint64_t key) const
+{
+  std::size_t mask(m_keys.size() - 1);
+  std::size_t slot(home(key));
+  while (m_counts[slot] && m_keys[slot] != key)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+
+/**
+ * Double the number of slots and reinsert all keys.
+ */
+void Cache::grow()
+{
+  std::vector<std::uint64_t> keys(m_keys.size() * 2);
+  std::vector<std::uint32_t> counts(m_counts.size() * 2);
+  keys.swap(m_keys);
+  counts.swap(m_counts);
+  m_shift--;
+  m_hand = 0;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (counts[i]) {
+      std::size_t slot(find(keys[i]));
+      m_keys[slot] = keys[i];
+      m_counts[slot] = counts[i];
+    }
+  }
+}
+
+
+/**
+ * Return the number of lookups that found their solution in the cache.
+ */
+unsigned long int Cache::hits() const
+{
+  return m_hits;
+}
+
+
+/**
+ * Return the key's home slot.
+ *
+ * The slot is taken from the key's top bits after a Fibonacci multiplication.
+ */
+std::size_t Cache::home(std::uint64_t key) const
+{
+  return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ULL) >> m_shift);
+}
+
+
+/**
+ * Return the fraction of the table's slots that are in use.
+ */
+double Cache::load_factor() const
+{
+  return static_cast<double>(m_size) / static_cast<double>(m_keys.size());
+}
+
+
+/**
+ * Return the number of lookups (calls to contains).
+ */
+unsigned long int Cache::lookups() const
+{
+  return m_lookups;
+}
+
+
+/**
+ * Return the number of bytes used by the cache.
+ */
+unsigned long int Cache::memory() const
+{
+  return sizeof(Cache) + m_keys.capacity() * sizeof(std::uint64_t) +
+    m_counts.capacity() * sizeof(std::uint32_t);
 }
 
 
@@ -57,39 +277,18 @@ unsigned long int Cache::contains(const Solution& s)
  */
 long unsigned int Cache::size() const
 {
-  return m_cache.size();
+  return m_size;
 }
 
 
 /**
- * Return simple hash of solution struct.
+ * Return the structural hash of the given solution.
  *
- * This hash is simply a rounded integer representation of the solution value.
- * This function assumes that the program is executed on a 64 bit processor =>
- * the maximum value of long unsigned int is 18,446,744,073,709,551,615.
+ * The solution's costs are not required; see hash_solution.
  */
 unsigned long int Cache::hash(const Solution& s) const
 {
-//   typedef unsigned long int uli;
-  // TODO
-//   long double cost(calc_cost(&m_cfg, s.trucks, s.workers_cache, s.dist_cache));
-//   std::cout << "trucks: " << s.trucks << "\n";  // TODO: remove
-//   std::cout << "workers_cache: " << s.workers_cache << "\n";  // TODO: remove
-//   std::cout << "dist_cache: " << s.dist_cache << "\n";  // TODO: remove
-//   std::cout << "cost: " << cost << "\n";  // TODO: remove
-//   uli multiple(std::numeric_limits<uli>::max() / uli(ceill(s.cost_cache)) / 10);
-//   long double max_div_10(std::numeric_limits<long double>::max() / 10.0);
-//   while (cost < max_div_10) {
-//     cost *= 10.0L;
-//   }
-//   unsigned long int hash_value(static_cast<unsigned long int>(s.cost_cache * multiple));
-  long double cost(s.cost_cache);
-  unsigned long int hash_value(static_cast<unsigned long int>(cost * m_factor));
-//   std::cout << hash_value << "\n";
-//   std::cout << "cost: " << cost << "\n";
-//   std::cout << "fact: " << m_factor << "\n";
-//   std::cout << "hash: " << hash_value << "\n";
-  return hash_value;
+  return static_cast<unsigned long int>(hash_solution(&s));
 }
 
 
@@ -97,15 +296,11 @@ unsigned long int Cache::hash(const Solution& s) const
  * Return the number of solutions querying the cache.
  *
  * This number is the total number of elements where elements that were
- * queried more than once are counted multiple times.
+ * queried more than once are counted multiple times (including evicted ones).
  */
 unsigned long int Cache::queries() const
 {
-  unsigned long int num_elements(0);
-  for (const std::map<unsigned long int, unsigned long int>::value_type& elem: m_cache) {
-    num_elements += elem.second;
-  }
-  return num_elements;
+  return m_adds + m_hits;
 }
 
 
@@ -122,7 +317,11 @@ std::ostream& operator<<(std::ostream& os, const Cache& c)
     os << "Cache statistics: \n";
     os << c.size() << " elements\n";
     os << c.queries() << " queries\n";
-    os << 100.0L * (c.queries() - c.m_cache.size()) / c.queries() << "% hits\n";
+    os << c.lookups() << " lookups\n";
+    os << 100.0L * c.hits() / c.lookups() << "% hits\n";
+    os << c.evictions() << " evictions\n";
+    os << c.memory() << " bytes\n";
+    os << c.load_factor() << " load factor\n";
   }
   return os;
 }
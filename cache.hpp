@@ -8,7 +8,8 @@
 #ifndef CACHE_H
 #define CACHE_H
 
-#include <map>
+#include <cstdint>
+#include <vector>
 
 #include <gtest/gtest_prod.h>
 
@@ -26,48 +27,68 @@ extern "C" {
  * solution has already been obtained in the past. This knowledge allows
  * skipping the expensive local search if it has already been performed.
  *
- * This caches is realized as a C++ mapping of solution hash values to the
- * number of times a particular hash has been encountered.
+ * This caches is realized as a mapping of solution hash values to the
+ * number of times a particular hash has been encountered. The mapping is a
+ * flat open addressing table with linear probing; it keeps 12 bytes per slot
+ * and doubles its capacity once it is three quarters full.
  *
- * The implementation below is extremely simplistic and mainly serves as a
- * proof of concept - it does not compare solutions for identity, but only
- * uses the solution's objective function value. This could lead to skipping
- * different solutions with identical objective function value. If this poses
- * a problem can be investigated later in case needed, but for now we go with
- * 'simple is beautiful'.
+ * The cache_max_bytes and cache_max_entries settings bound the table; caches
+ * that are used together split the budget (see the constructor). Once it is
+ * full, adding a solution evicts another one. Eviction follows the
+ * CLOCK policy with the encounter counters as reference counts: the clock
+ * hand halves every counter it passes and evicts the first solution that
+ * was not encountered again. Hence, frequently hit solutions are kept, but
+ * their counters are only approximate after evictions.
  *
- * Some alternative hashing strategies include
- * - sum(node->alst - node->aest) for all nodes
- * - sum(node->aest) for all nodes
- * - sum(node->alst) for all nodes
- * - length of longest route
- * - length of shortest route
- * - sum of node ids of all routes first non-depot nodes
- * - sum of node ids of all routes last non-depot nodes
- * - hash routes separately, then sum up the route hashes to avoid permutation issues
- * Note that these strategies can also be combined.
+ * The hash is a structural fingerprint of the solution (see hash_solution):
+ * the routes keep Zobrist hashes of their arcs up to date while they are
+ * modified, so hashing a solution does not require walking its nodes or
+ * calculating its costs. Solutions are identical if they have the same
+ * routes (in any order) with the same numbers of workers; only identical
+ * solutions are skipped (barring 64 bit hash collisions).
  */
 class Cache {
 public:
-  explicit Cache(const Problem& pb);
+  explicit Cache(const Problem& pb, long int shares = 1);
 
   void add(const Solution& s);
+  void add_key(std::uint64_t key);
   long unsigned int contains(const Solution& s);
+  unsigned long int count_key(std::uint64_t key);
+  unsigned long int evictions() const;
+  unsigned long int hits() const;
+  double load_factor() const;
+  unsigned long int lookups() const;
+  unsigned long int memory() const;
   unsigned long int size() const;
-//   unsigned long int memory();
 
 private:
+  void erase(std::size_t slot);
+  void evict();
+  std::size_t find(std::uint64_t key) const;
+  void grow();
+  std::size_t home(std::uint64_t key) const;
   unsigned long int hash(const Solution& s) const;
   unsigned long int queries() const;
 
-  std::map<unsigned long int,unsigned long int> m_cache;
+  std::vector<std::uint64_t> m_keys;  // the solutions' hashes
+  std::vector<std::uint32_t> m_counts;  // encounters per key (0: empty slot)
+  std::size_t m_size;  // number of keys in the table
+  std::size_t m_max_size;  // evict once the table holds this many keys
+  std::size_t m_hand;  // the clock hand's slot (see evict)
+  int m_shift;  // 64 - log2(number of slots)
+  unsigned long int m_adds;
+  unsigned long int m_lookups;
+  unsigned long int m_hits;
+  unsigned long int m_evictions;
   const Config& m_cfg;
-  unsigned long int m_factor;
 
   friend std::ostream& operator<< (std::ostream& os, const Cache& c);
 
   FRIEND_TEST(TestCache, test_add_one);
   FRIEND_TEST(TestCache, test_add_three);
+  FRIEND_TEST(TestCache, test_evict);
+  FRIEND_TEST(TestCache, test_grow);
   FRIEND_TEST(TestCache, test_hash);
 };
 
@@ -7,6 +7,7 @@
 
 #include <cmath>
 #include <iostream>
+#include <mutex>
 #include <time.h>
 
 extern "C" {
@@ -15,6 +16,7 @@ extern "C" {
   #include "config.h"
   #include "local_search.h"
   #include "problemreader.h"
+  #include "rng.h"
   #include "solution.h"
   #include "vrptwms.h"
 }
@@ -25,6 +27,111 @@ extern "C" {
 
 
 
+/**
+ * The cache and its bookkeeping shared by the threads constructing ants.
+ */
+struct Cached_Ants {
+  Cache& cache;
+  Cache& ls_cache;  // states reached by the local search (see skip_known_state)
+  std::mutex lock;
+  unsigned long int max_hits;
+  bool saturized;
+};
+
+
+/**
+ * Return nonzero if the given ant is already cached (it is skipped then).
+ *
+ * New ants are added to the cache. This is the threaded equivalent of the
+ * cache lookup in run_generations; it is called concurrently.
+ */
+static int skip_cached_ant(Solution* sol, void* data) {
+  Cached_Ants* ants = static_cast<Cached_Ants*>(data);
+  Problem* pb = sol->pb;
+  std::lock_guard<std::mutex> guard(ants->lock);
+  unsigned long int hits = ants->cache.contains(*sol);
+  if (hits) {
+    if (hits > ants->max_hits and !ants->saturized) {
+      ants->saturized = true;
+      pb->sol->saturation_time = time((time_t*)NULL) - pb->start_time;
+    }
+    return 1;
+  }
+  ants->cache.add(*sol);
+  return 0;
+}
+
+
+/**
+ * Return nonzero if the local search reached a known state.
+ *
+ * See do_ls_filtered; new states are added to the second level cache. It is
+ * called concurrently.
+ */
+static int skip_known_state(std::uint64_t state, void* data) {
+  Cached_Ants* ants = static_cast<Cached_Ants*>(data);
+  std::lock_guard<std::mutex> guard(ants->lock);
+  if (ants->ls_cache.count_key(state))
+    return 1;
+  ants->ls_cache.add_key(state);
+  return 0;
+}
+
+
+/**
+ * Construct and improve the generations of ants one after another.
+ *
+ * Ants that are already cached are skipped before their local search.
+ */
+static void run_generations(Problem* pb, int workers, Cached_Ants& ants)
+{
+  Cache& cache = ants.cache;
+  double best_cost = INFINITY;
+  double cost = INFINITY;
+  Solution* temp = NULL;
+  unsigned long int hits = 0;
+  Solution* sol = new_solution(pb);
+  while (proceed(pb, (unsigned long) pb->num_solutions)) {
+    for (int i = 0; i < pb->ants; ++i) {  // solve once for each ant
+      reset_solution(sol, pb->inst->num_nodes);
+      aco_construct_routes(sol, workers);
+
+      hits = cache.contains(*sol);
+      if (hits) {
+        if (hits > ants.max_hits and !ants.saturized) {
+          ants.saturized = true;
+          pb->sol->saturation_time = time((time_t*)NULL) - pb->start_time;
+//           if (pb->cfg->verbosity == DEBUG_CACHE) {
+//             std::cout << "HIT!! -> resetting pheromone\n";
+//           }
+//           shake_pheromone(pb);
+//           reset_pheromone(pb);  // TODO: maybe skip and only tweak parameters
+//           pb->cfg->alpha = rand_uniform(&pb->rng);  // TODO: maybe try range(0.9, 0.0, -0.1)
+//           max_hits += 2;  // TODO: make configurable or remove (after testing)
+        }
+        continue;
+      }
+      cache.add(*sol);
+
+      if (do_ls_filtered(sol, skip_known_state, &ants))
+        continue;
+      cost = calc_costs(sol, pb->cfg);
+      if (cost < best_cost) {
+        best_cost = cost;
+        sol->time = time((time_t*)NULL) - pb->start_time;
+        print_progress(sol);
+        temp = pb->sol;
+        pb->sol = sol;
+        sol = temp;
+      }
+    }
+    pb->num_solutions += pb->ants;
+    update_pheromone(pb, pb->sol);
+  }
+  free_solution(sol);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Public Functions                                                          //
 ///////////////////////////////////////////////////////////////////////////////
@@ -46,12 +153,7 @@ extern "C" void c_solve_cached_aco(Problem* pb, int workers)
  * hence not updated by this function either.
  */
 static void reset_pheromone(Problem* pb) {
-  double** p_m = pb->pheromone;
-  for (int i = 1; i < (2 * pb->num_nodes - 1); ++i) {  // ignore 0 DEPOT
-    for (int j = 1; j < (2 * pb->num_nodes - 1); ++j) {
-      p_m[i][j] = pb->cfg->initial_pheromone;
-    }
-  }
+  set_pheromone(pb, pb->cfg->initial_pheromone);
   #ifdef DEBUG
   if (pb->cfg->verbosity == DEBUG_CACHE) {
     printf("resetting pheromone...\n");
@@ -69,16 +171,19 @@ static void reset_pheromone(Problem* pb) {
 static void shake_pheromone(Problem* pb) {
   double** p_m = pb->pheromone;
   double new_pheromone = 1.0, min_pheromone = pb->cfg->min_pheromone;
-  for (int i = 1; i < (2 * pb->num_nodes - 1); ++i) {  // ignore 0 DEPOT
-    for (int j = 1; j < (2 * pb->num_nodes - 1); ++j) {
-      new_pheromone = drand48();
+  for (int i = 1; i < (2 * pb->inst->num_nodes - 1); ++i) {  // ignore 0 DEPOT
+    for (int j = 1; j < (2 * pb->inst->num_nodes - 1); ++j) {
+      new_pheromone = rand_uniform(&pb->rng);
       p_m[i][j] = max(new_pheromone, min_pheromone);
     }
   }
+  pb->pheromone_scale = 1.0;  // the values are stored without evaporation
+  pb->pheromone_floor = min_pheromone;
   #ifdef DEBUG
   if (pb->cfg->verbosity == DEBUG_CACHE) {
     printf("shaking pheromone to\n");
-    print_double_matrix(2 * pb->num_nodes - 1, pb->pheromone, "pheromone");
+    print_double_matrix(2 * pb->inst->num_nodes - 1, pb->pheromone,
+                        "pheromone");
   }
   #endif
 }
@@ -93,53 +198,15 @@ static void shake_pheromone(Problem* pb) {
  */
 void solve_cached_aco(Problem* pb, int workers)
 {
-  double best_cost = INFINITY;
-  double cost = INFINITY;
-  Solution* sol = new_solution(pb);
-  Solution* temp = NULL;
-  Cache cache(*pb);
-  unsigned long int hits = 0;
+  Cache cache(*pb, 2);  // the caches split the budget
+  Cache ls_cache(*pb, 2);
   unsigned long int max_hits = 5;  // TODO: make configurable
   bool saturized = false;  // to measure if speedups can be gained
-  while (proceed(pb, (unsigned long) pb->num_solutions)) {
-    for (int i = 0; i < pb->cfg->ants; ++i) {  // solve once for each ant
-      reset_solution(sol, pb->num_nodes);
-      aco_construct_routes(sol, workers);
-
-      cost = calc_costs(sol, pb->cfg);  // required for cache; TODO: refactor!!!
-      hits = cache.contains(*sol);
-      if (hits) {
-        if (hits > max_hits and !saturized) {
-          saturized = true;
-          pb->sol->saturation_time = time((time_t*)NULL) - pb->start_time;
-//           if (pb->cfg->verbosity == DEBUG_CACHE) {
-//             std::cout << "HIT!! -> resetting pheromone\n";
-//           }
-//           shake_pheromone(pb);
-//           reset_pheromone(pb);  // TODO: maybe skip and only tweak parameters
-//           pb->cfg->alpha = drand48();  // TODO: maybe try range(0.9, 0.0, -0.1)
-//           max_hits += 2;  // TODO: make configurable or remove (after testing)
-        }
-        continue;
-      }
-      cache.add(*sol);
-
-      sol = do_ls(sol);
-      cost = calc_costs(sol, pb->cfg);
-      if (cost < best_cost) {
-        best_cost = cost;
-        sol->time = time((time_t*)NULL) - pb->start_time;
-        print_progress(sol);
-        temp = pb->sol;
-        pb->sol = sol;
-        sol = temp;
-      }
-    }
-    pb->num_solutions += pb->cfg->ants;
-    update_pheromone(pb, pb->sol);
-  }
-
-  //   std::cout << cache << "\n";  // TODO: remove
-  free_solution(sol);
+  Cached_Ants ants{cache, ls_cache, {}, max_hits, saturized};
+  if (pb->cfg->threads > 1)
+    solve_aco_threaded(pb, workers, skip_cached_ant, skip_known_state, &ants);
+  else
+    run_generations(pb, workers, ants);
+  if (pb->cfg->verbosity >= BASIC_DEBUG)
+    std::cout << "ants\n" << cache << "local search states\n" << ls_cache;
 }
-
@@ -7,6 +7,7 @@
 
 #include <cmath>
 #include <iostream>
+#include <mutex>
 #include <time.h>
 
 extern "C" {
@@ -25,41 +26,66 @@ extern "C" {
 
 
 
-///////////////////////////////////////////////////////////////////////////////
-// Public Functions                                                          //
-///////////////////////////////////////////////////////////////////////////////
+/**
+ * The cache shared by the threads running GRASP iterations.
+ */
+struct Cached_Iterations {
+  Cache& cache;
+  Cache& ls_cache;  // states reached by the local search (see skip_known_state)
+  std::mutex lock;
+};
 
 
 /**
- * Wrapper function to allow using solve_cached_aco from C.
+ * Return nonzero if the given solution is already cached (it is skipped then).
+ *
+ * New solutions are added to the cache. This is the threaded equivalent of
+ * the cache lookup in run_iterations; it is called concurrently.
  */
-void c_solve_cached_grasp(Problem* pb, int workers)
-{
-  solve_cached_grasp(pb, workers);
+static int skip_cached_solution(Solution* sol, void* data) {
+  Cached_Iterations* iterations = static_cast<Cached_Iterations*>(data);
+  std::lock_guard<std::mutex> guard(iterations->lock);
+  if (iterations->cache.contains(*sol))
+    return 1;
+  iterations->cache.add(*sol);
+  return 0;
 }
 
 
 /**
- * Solve the given problem with the ACO metaheuristic using a caching mechanism.
+ * Return nonzero if the local search reached a known state.
  *
- * This metaheuristic keeps track on how often a cache value has been hit.
- * This allows to react if the same cache value is hit over and over again by
- * resetting or shaking the pheromone data structure.
+ * See do_ls_filtered; new states are added to the second level cache. It is
+ * called concurrently.
  */
-void solve_cached_grasp(Problem* pb, int workers)
+static int skip_known_state(std::uint64_t state, void* data) {
+  Cached_Iterations* iterations = static_cast<Cached_Iterations*>(data);
+  std::lock_guard<std::mutex> guard(iterations->lock);
+  if (iterations->ls_cache.count_key(state))
+    return 1;
+  iterations->ls_cache.add_key(state);
+  return 0;
+}
+
+
+/**
+ * Run the GRASP iterations one after another.
+ *
+ * Solutions that are already cached are skipped before their local search.
+ */
+static void run_iterations(Problem* pb, int workers,
+                           Cached_Iterations& iterations)
 {
-  std::cout << "WARNING: Implementation not finished yet!\n";  // TODO: remove
-  Cache cache(*pb);
+  Cache& cache = iterations.cache;
   double best_cost = INFINITY;
   double cost = INFINITY;
   unsigned long int hits = 0, max_hits = 5;  // TODO: make configurable
   Solution* sol = new_solution(pb);
   Solution* temp = NULL;
   while (proceed(pb, (unsigned long) pb->num_solutions)) {
-    reset_solution(sol, pb->num_nodes);
+    reset_solution(sol, pb->inst->num_nodes);
     pb->num_solutions++;
     grasp_construct_routes(sol, workers);
-    cost = calc_costs(sol, pb->cfg);
     hits = cache.contains(*sol);
     if (hits) {
 //       if (hits > max_hits) {
@@ -70,7 +96,8 @@ void solve_cached_grasp(Problem* pb, int workers)
       continue;
     }
     cache.add(*sol);
-    sol = do_ls(sol);
+    if (do_ls_filtered(sol, skip_known_state, &iterations))
+      continue;
     cost = calc_costs(sol, pb->cfg);
     if (cost < best_cost) {
       best_cost = cost;
@@ -81,6 +108,42 @@ void solve_cached_grasp(Problem* pb, int workers)
       sol = temp;
     }
   }
-  std::cout << cache << "\n";  // TODO: remove
   free_solution(sol);
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Functions                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * Wrapper function to allow using solve_cached_aco from C.
+ */
+void c_solve_cached_grasp(Problem* pb, int workers)
+{
+  solve_cached_grasp(pb, workers);
+}
+
+
+/**
+ * Solve the given problem with the ACO metaheuristic using a caching mechanism.
+ *
+ * This metaheuristic keeps track on how often a cache value has been hit.
+ * This allows to react if the same cache value is hit over and over again by
+ * resetting or shaking the pheromone data structure.
+ */
+void solve_cached_grasp(Problem* pb, int workers)
+{
+  std::cout << "WARNING: Implementation not finished yet!\n";  // TODO: remove
+  Cache cache(*pb, 2);  // the caches split the budget
+  Cache ls_cache(*pb, 2);
+  Cached_Iterations iterations{cache, ls_cache, {}};
+  if (pb->cfg->threads > 1)
+    solve_grasp_threaded(pb, workers, skip_cached_solution, skip_known_state,
+                         &iterations);
+  else
+    run_iterations(pb, workers, iterations);
+  if (pb->cfg->verbosity >= BASIC_DEBUG)
+    std::cout << "solutions\n" << cache << "local search states\n" << ls_cache;
+}
@@ -40,6 +40,9 @@ static void print_help(char *progname, Config *cfg) {
   printf("%scurrently set to %.1f\n", indent, cfg->alpha);
   printf("%s--ants=%%d          ", lo);
   printf("number of ants; currently set to %ld\n", cfg->ants);
+  printf("%s--cache-max-bytes=%%ld ", lo);
+  printf("memory bound of the solution cache (0 for unbounded)\n");
+  printf("%scurrently set to %ld\n", indent, cfg->cache_max_bytes);
   printf("  -c  --construct=%%s     ");
   printf("select route construction heuristic\n");
   printf("%s'%s' for Solomon I1\n", indent, START_HEURISTICS[SOLOMON]);
@@ -68,6 +71,9 @@ static void print_help(char *progname, Config *cfg) {
   printf("%scurrently set to %ld\n", indent, cfg->max_iterations);
   printf("%s--ls=%%d            enable (1)/ disable (0) local search\n", lo);
   printf("%scurrently set to %d\n", indent, cfg->do_ls);
+  printf("%s--ls-threads=%%ld   ", lo);
+  printf("number of threads evaluating the best moves\n");
+  printf("%scurrently set to %ld\n", indent, cfg->ls_threads);
   printf("  -m  --metaheuristic=%%s ");
   printf("use the given metaheuristic\n%s'%s' to disable metaheuristics\n",
          indent, METAHEURISTICS[NO_METAHEURISTIC]);
@@ -90,6 +96,9 @@ static void print_help(char *progname, Config *cfg) {
   printf("%scurrently set to %ld\n", indent, cfg->runtime);
   printf("%s--seed=%%ld         ", lo);
   printf("select the seed for the pseudo random number generator\n");
+  printf("%s--threads=%%ld      ", lo);
+  printf("number of threads constructing solutions (ACO and GRASP)\n");
+  printf("%scurrently set to %ld\n", indent, cfg->threads);
   printf("  -v  --verbose          ");
   printf("increase the configuration's verbosity level by one\n");
   printf("%scan be used multiple times\n", indent);
@@ -118,9 +127,10 @@ int main(int argc, char *argv[]) {
   Resultlist* results = (Resultlist*) NULL;
   Resultlist* tail = (Resultlist*) NULL;
   while (1) {
-    static struct option long_options[] = {  // highest used id: 1010
+    static struct option long_options[] = {  // highest used id: 1013
     {"alpha",             required_argument, 0, 1000},
     {"ants",              required_argument, 0, 1005},
+    {"cache-max-bytes",   required_argument, 0, 1013},
     {"construct",         required_argument, 0,  'c'},
     {"deterministic",     no_argument,       0,  'd'},
     {"format",            required_argument, 0, 1003},
@@ -129,11 +139,13 @@ int main(int argc, char *argv[]) {
     {"help",              no_argument,       0,  'h'},
     {"iterations",        required_argument, 0, 1006},
     {"ls",                required_argument, 0, 1004},
+    {"ls-threads",        required_argument, 0, 1012},
     {"metaheuristic",     required_argument, 0,  'm'},
     {"parallel",          no_argument,       0, 1008},
     {"print-config",      no_argument,       0, 1001},
     {"runtime",           required_argument, 0,  'r'},
     {"seed",              required_argument, 0, 1002},
+    {"threads",           required_argument, 0, 1011},
     {"verbose",           no_argument,       0,  'v'},
     {"vrptw",             no_argument,       0, 1007},
     {0, 0, 0, 0}
@@ -193,6 +205,15 @@ int main(int argc, char *argv[]) {
       case 1010:  // --grasp-use-weights=
         cfg->use_weights = (cfg_bool_t) atoi(optarg);
         break;
+      case 1011:  // --threads=
+        cfg->threads = atol(optarg);
+        break;
+      case 1012:  // --ls-threads=
+        cfg->ls_threads = atol(optarg);
+        break;
+      case 1013:  // --cache-max-bytes=
+        cfg->cache_max_bytes = atol(optarg);
+        break;
       case 'c':
         config_set_start_heuristic(&cfg->start_heuristic, optarg);
         break;
@@ -220,7 +241,6 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "invalid configuration, exiting\n");
     exit(EXIT_FAILURE);
   }
-  srand48(cfg->seed);
 
   if (!cfg->parallel)
     fprint_config_summary(stdout, cfg);
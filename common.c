@@ -133,6 +133,35 @@ void print_double_matrix(int num, double** matrix, const char* name) {
 }
 
 
+//! Print a matrix stored in a contiguous block with the given row stride.
+void print_flat_double_matrix(int num, const double* matrix, size_t stride,
+                              const char* name) {
+  printf ("%dx%d ", num, num);
+  if (num > 10) {
+    printf ("(truncated) ");
+  }
+  printf ("%s\n", name);
+  for (int i = 0; i < num; i++) {
+    if (i == 5 && num > 13) {
+      printf (" ... ");
+    } else if (i > 5 && num - i > 5 && num > 13) {
+      continue;
+    } else {
+      for (int j = 0; j < num; j++) {
+        if (j == 5 && num - j > 5) {
+          printf ("... ");
+        } else if (j > 5 && num - j > 5) {
+          continue;
+        } else {
+          printf ("%4.5f ", matrix[(size_t) i * stride + (size_t) j]);
+        }
+      }
+    }
+    printf ("\n");
+  }
+}
+
+
 void set_double_matrix(double** matrix, size_t rows, size_t cols, double val) {
   for (size_t i = 0; i < rows; ++i) {
     for (size_t j = 0; j < cols; ++j) {
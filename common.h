@@ -9,7 +9,7 @@
 #define COMMON_H
 
 #ifndef _XOPEN_SOURCE
-#define _XOPEN_SOURCE 600  // Request non-standard functions (drand48 et al.)
+#define _XOPEN_SOURCE 600  // Request non-standard functions (barriers et al.)
 #endif
 
 #include <stddef.h>
@@ -17,16 +17,23 @@
 static const double MIN_DELTA = 1e-13;  // avoid infinite loop
 static const int DEPOT = 0;  // the depot's node id
 static const int UNLIMITED = 0;
+static const size_t CACHE_LINE = 64;  // bytes; alignment of hot data blocks
 
 typedef struct config Config;
 typedef struct insertion Insertion;
 typedef struct insertion_list Insertion_List;
+typedef struct instance Instance;
+typedef struct journal Journal;
 typedef struct move Move;
+typedef struct move_evaluator Move_Evaluator;
 typedef struct node Node;
 typedef struct past_move PastMove;
 typedef struct resultlist Resultlist;
+typedef struct rng Rng;
 typedef struct route Route;
+typedef struct route_array Route_Array;
 typedef struct problem Problem;
+typedef struct segment Segment;
 typedef struct solution Solution;
 typedef struct stats Stats;
 typedef struct tabulist Tabulist;
@@ -41,10 +48,16 @@ int* init_int_vector(size_t dim, int val);
 unsigned long** init_unsigned_long_matrix(size_t rows, size_t cols,
                                           unsigned long val);
 void print_double_matrix(int num, double** matrix, const char* name);
+void print_flat_double_matrix(int num, const double* matrix, size_t stride,
+                              const char* name);
 void set_double_matrix(double** matrix, size_t rows, size_t cols, double val);
 
 static inline double max(double x, double y) {
   return x > y ? x : y;
 }
 
+static inline double min(double x, double y) {
+  return x < y ? x : y;
+}
+
 #endif
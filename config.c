@@ -69,6 +69,8 @@ void config_set_default_values(Config* cfg) {
   cfg->alpha = 1.0;
   cfg->ants = 0;
   cfg->best_moves = cfg_true;
+  cfg->cache_max_bytes = 0L;
+  cfg->cache_max_entries = 0L;
   cfg->cost_truck = 1.0;
   cfg->cost_worker = 0.1;
   cfg->cost_distance = 0.0001;
@@ -76,7 +78,10 @@ void config_set_default_values(Config* cfg) {
   cfg->do_ls = cfg_true;
   config_set_output_format(&cfg->format, "human");
   cfg->initial_pheromone = 1.0;
+  cfg->jobs = 1L;
   cfg->lambda = 2.0;
+  cfg->lazy_costs = cfg_false;
+  cfg->ls_threads = 1L;
   cfg->max_failed_attempts = 500L;
   cfg->max_iterations = 0L;
   cfg->max_move = 2L;
@@ -86,6 +91,7 @@ void config_set_default_values(Config* cfg) {
   config_set_metaheuristic(&cfg->metaheuristic, "aco");
   cfg->min_pheromone = 0.0000000000001;
   cfg->mu = 1.0;
+  cfg->neighbours = 0L;
   cfg->parallel = cfg_false;
   cfg->rcl_size = 2;
   cfg->rho = 0.985;
@@ -97,6 +103,7 @@ void config_set_default_values(Config* cfg) {
   cfg->stats_filename = s_malloc(sizeof(char) * 10);
   strcpy(cfg->stats_filename, "stats.txt");
   cfg->tabutime = 50;
+  cfg->threads = 1L;
   cfg->truck_velocity = 1.0;
   cfg->use_weights = cfg_true;
   cfg->verbosity = 0L;
@@ -135,11 +142,12 @@ static void fprint_local_search(FILE* stream, Config* cfg) {
   if (cfg->do_ls) {
     fprintf(stream, "local search ");
     if (cfg->best_moves)
-      fprintf(stream, "(only best moves; max_move: %ld, max_swap: %ld)\n",
+      fprintf(stream, "(only best moves; max_move: %ld, max_swap: %ld, ",
              cfg->max_move, cfg->max_swap);
     else
-      fprintf(stream, "(first improving moves; max_move: %ld, max_swap: %ld)\n",
+      fprintf(stream, "(first improving moves; max_move: %ld, max_swap: %ld, ",
              cfg->max_move, cfg->max_swap);
+    fprintf(stream, "max_optimize: %ld)\n", cfg->max_optimize);
   } else {
     fprintf(stream, "no local search\n");
   }
@@ -228,14 +236,43 @@ int config_is_valid(Config* cfg) {
     fprintf(stderr, "ERROR: iterations or runtime must be finite (> 0)\n");
     valid = 0;
   }
+  if (cfg->cache_max_bytes < 0 || cfg->cache_max_entries < 0) {
+    fprintf(stderr, "ERROR: cache_max_bytes and cache_max_entries have to be "
+            ">= 0\n");
+    valid = 0;
+  }
   if (cfg->max_move < 0) {
     fprintf(stderr, "ERROR: max_move has to be >= 0)\n");
     valid = 0;
   }
+  if (cfg->max_optimize < 0) {
+    fprintf(stderr, "ERROR: max_optimize has to be >= 0)\n");
+    valid = 0;
+  }
   if (cfg->max_swap < 0) {
     fprintf(stderr, "ERROR: max_swap has to be >= 0)\n");
     valid = 0;
   }
+  if (cfg->threads < 1) {
+    fprintf(stderr, "ERROR: threads has to be >= 1\n");
+    valid = 0;
+  }
+  if (cfg->ls_threads < 1) {
+    fprintf(stderr, "ERROR: ls_threads has to be >= 1\n");
+    valid = 0;
+  }
+  if (cfg->threads > 1 && cfg->ls_threads > 1) {
+    fprintf(stderr, "ERROR: ls_threads has to be 1 if threads > 1\n");
+    valid = 0;
+  }
+  if (cfg->jobs < 1) {
+    fprintf(stderr, "ERROR: jobs has to be >= 1\n");
+    valid = 0;
+  }
+  if (cfg->neighbours < 0) {
+    fprintf(stderr, "ERROR: neighbours has to be >= 0 (0 for all nodes)\n");
+    valid = 0;
+  }
   return valid;
 }
 
@@ -302,6 +339,8 @@ Config* get_config(char *fname) {
     CFG_SIMPLE_FLOAT("alpha", &cfg->alpha),
     CFG_SIMPLE_INT("ants", &cfg->ants),
     CFG_SIMPLE_BOOL("best_moves", &cfg->best_moves),
+    CFG_SIMPLE_INT("cache_max_bytes", &cfg->cache_max_bytes),
+    CFG_SIMPLE_INT("cache_max_entries", &cfg->cache_max_entries),
     CFG_SIMPLE_FLOAT("cost_truck", &cfg->cost_truck),
     CFG_SIMPLE_FLOAT("cost_worker", &cfg->cost_worker),
     CFG_SIMPLE_FLOAT("cost_distance", &cfg->cost_distance),
@@ -309,7 +348,10 @@ Config* get_config(char *fname) {
     CFG_SIMPLE_BOOL("do_ls", &cfg->do_ls),
     CFG_STR("format", NOT_SET, CFGF_NONE),
     CFG_SIMPLE_FLOAT("initial_pheromone", &cfg->initial_pheromone),
+    CFG_SIMPLE_INT("jobs", &cfg->jobs),
     CFG_SIMPLE_FLOAT("lambda", &cfg->lambda),
+    CFG_SIMPLE_BOOL("lazy_costs", &cfg->lazy_costs),
+    CFG_SIMPLE_INT("ls_threads", &cfg->ls_threads),
     CFG_SIMPLE_INT("max_failed_attempts", &cfg->max_failed_attempts),
     CFG_SIMPLE_INT("max_iterations", &cfg->max_iterations),
     CFG_SIMPLE_INT("max_move", &cfg->max_move),
@@ -319,6 +361,7 @@ Config* get_config(char *fname) {
     CFG_STR("metaheuristic", NOT_SET, CFGF_NONE),
     CFG_SIMPLE_FLOAT("min_pheromone", &cfg->min_pheromone),
     CFG_SIMPLE_FLOAT("mu", &cfg->mu),
+    CFG_SIMPLE_INT("neighbours", &cfg->neighbours),
     CFG_SIMPLE_BOOL("parallel", &cfg->parallel),
     CFG_SIMPLE_INT("rcl_size", &cfg->rcl_size),
     CFG_SIMPLE_FLOAT("rho", &cfg->rho),
@@ -328,6 +371,7 @@ Config* get_config(char *fname) {
     CFG_STR("start_heuristic", NOT_SET, CFGF_NONE),
     CFG_SIMPLE_STR("stats_filename", &stats_filename),
     CFG_SIMPLE_INT("tabutime", &cfg->tabutime),
+    CFG_SIMPLE_INT("threads", &cfg->threads),
     CFG_SIMPLE_FLOAT("truck_velocity", &cfg->truck_velocity),
     CFG_SIMPLE_BOOL("use_weights", &cfg->use_weights),
     CFG_SIMPLE_INT("verbosity", &cfg->verbosity),
@@ -380,7 +424,13 @@ void print_config(Config *cfg) {
       printf("print basic debug output\n");
   }
   printf("output format: %s\n", get_output_format(cfg));
-  printf("max workers per truck: %ld\n\n", cfg->max_workers);
+  printf("max workers per truck: %ld\n", cfg->max_workers);
+  printf("cost matrices: %s\n",
+         cfg->lazy_costs ? "distances only (lazy service times)" : "full");
+  if (cfg->neighbours)
+    printf("granular neighbours: %ld per node\n\n", cfg->neighbours);
+  else
+    printf("granular neighbours: all nodes\n\n");
   printf("metaheuristic: ");
   fprint_metaheuristic(stdout, cfg);
   if (cfg->metaheuristic) {
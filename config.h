@@ -67,6 +67,8 @@ struct config {
   long int ants;  //!< number of ants for ACO; set to number of customers if 0
   int ants_dynamic;  //!< if true, set ants to the # of customers
   cfg_bool_t best_moves;
+  long int cache_max_bytes;  //!< Memory bound of the solution cache; 0: none.
+  long int cache_max_entries;  //!< Entry bound of the cache; 0: none.
   double cost_truck;
   double cost_worker;
   double cost_distance;
@@ -74,7 +76,10 @@ struct config {
   cfg_bool_t do_ls;
   int format;
   double initial_pheromone;
+  long int jobs;  //!< Number of instances solved concurrently.
   double lambda;
+  cfg_bool_t lazy_costs;  //!< Add service times on the fly (no matrices).
+  long int ls_threads;  //!< Number of threads evaluating the best moves.
   long int max_failed_attempts;
   long int max_iterations;  //!< For metaheuristics; 0 for infinite.
   long int max_move;
@@ -84,6 +89,7 @@ struct config {
   int metaheuristic;
   double min_pheromone;
   double mu;
+  long int neighbours;  //!< Granular neighbours per node; 0 for all nodes.
   cfg_bool_t parallel;
   long int rcl_size;  //!< Size of the restricted candidate list (GRASP).
   double rho;  //!< Pheromone persistence.
@@ -94,6 +100,7 @@ struct config {
   int start_heuristic;
   char* stats_filename;
   long int tabutime;  //!< Affects the size of the tabu list/ tabu time.
+  long int threads;  //!< Number of threads for ACO and GRASP.
   double truck_velocity;
   cfg_bool_t use_weights;  //!< Use weighted roulette wheel for GRASP.
   long int verbosity;
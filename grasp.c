@@ -5,13 +5,18 @@
  *
  */
 
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "common.h"
 #include "config.h"
 #include "local_search.h"
 #include "node.h"
 #include "problemreader.h"
+#include "rng.h"
 #include "route.h"
 #include "solution.h"
 #include "vrptwms.h"
@@ -23,13 +28,55 @@
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
 
+//! Data shared by all threads of a threaded GRASP run.
+typedef struct grasp_shared {
+  Problem* pb;
+  int workers;
+  Solution_Filter filter;  //!< Optional; NULL to keep all solutions.
+  State_Filter ls_filter;  //!< Optional; see do_ls_filtered.
+  void* data;  //!< Passed to the filters.
+  double best_cost;  //!< Best cost found by any thread (atomically updated).
+} Grasp_Shared;
+
+//! A thread running GRASP iterations.
+//! Aligned to a cache line as the threads are stored next to each other.
+typedef struct grasp_thread {
+  pthread_t thread;
+  Grasp_Shared* shared;
+  Rng rng;  //!< The thread's own random number generator.
+  Move_Evaluator* evaluator;  //!< The thread's own evaluator.
+  Solution* sol;  //!< Scratch solution.
+  Solution* best;  //!< The thread's last solution that was the overall best.
+  double best_cost;
+} __attribute__ ((aligned (64))) Grasp_Thread;
+
+static int claim_iteration(Problem* pb);
 static void grasp_solve_solomon(Solution* sol, int workers);
+static int publish_cost(double* best_cost, double cost);
+static void* run_grasp(void* grasp_thread);
+
+
+//! Claim the next iteration of the given problem for the calling thread.
+//! The iteration counter is shared by all threads; it is only incremented if
+//! the solver may proceed.
+//! \return 1 if the iteration was claimed, 0 if the solver has to stop.
+static int claim_iteration(Problem* pb) {
+  long n = __atomic_load_n(&pb->num_solutions, __ATOMIC_RELAXED);
+  do {
+    if (!proceed(pb, (unsigned long) n))
+      return 0;
+  } while (!__atomic_compare_exchange_n(&pb->num_solutions, &n, n + 1, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  return 1;
+}
 
 
 //! Create an initial solution using Solomon's I1 heuristic.
 //! The heuristic has been adapted for the GRASP metaheuristic.
 static void grasp_solve_solomon(Solution* sol, int workers) {
-  Insertion_List il; init_insertion_list(&il, sol->pb->cfg->rcl_size);
+  Insertion_List il;  // at most one candidate per unrouted node
+  init_insertion_list(&il, sol->pb->cfg->rcl_size, sol->num_unrouted);
+  Insertion candidate;
   Insertion* ins = (Insertion*) NULL;
   while (sol->unrouted) {
     Node *unrouted = get_seed(sol);
@@ -38,18 +85,59 @@ static void grasp_solve_solomon(Solution* sol, int workers) {
     while (sol->unrouted) {  // fill the current route
       unrouted = sol->unrouted;
       while (unrouted) {
-        ins = get_best_insertion(route, unrouted);
-        if (ins)
-          update_insertion_list(&il, ins);
+        if (get_best_insertion(route, unrouted, &candidate))
+          update_insertion_list(&il, &candidate);
         unrouted = unrouted->next;
       }
-      ins = pick_insertion(&il, sol->pb->cfg->use_weights);
+      ins = pick_insertion(&il, sol->pb->cfg->use_weights, sol->rng);
       if (!ins) break;
       remove_unrouted(sol, ins->node);
       add_nodes(ins->target, ins->node, ins->node, ins->after);
       reset_insertion_list(&il);
     }
   }
+  free_insertion_list(&il);
+}
+
+
+//! Lower the shared best cost to the given cost if it is an improvement.
+//! Lock-free; of several threads offering an improvement at the same time,
+//! each one only succeeds if its cost is lower than all previous ones.
+//! \return 1 if the given cost is the best so far, otherwise 0.
+static int publish_cost(double* best_cost, double cost) {
+  double current;
+  __atomic_load(best_cost, &current, __ATOMIC_ACQUIRE);
+  while (cost < current) {
+    if (__atomic_compare_exchange(best_cost, &current, &cost, 0,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      return 1;
+  }
+  return 0;
+}
+
+
+//! Run GRASP iterations until the solver has to stop.
+//! A solution is only kept if it improves the overall best cost.
+static void* run_grasp(void* grasp_thread) {
+  Grasp_Thread* gt = (Grasp_Thread*) grasp_thread;
+  Grasp_Shared* shared = gt->shared;
+  Problem* pb = shared->pb;
+  while (claim_iteration(pb)) {
+    reset_solution(gt->sol, pb->inst->num_nodes);
+    grasp_construct_routes(gt->sol, shared->workers);
+    if (shared->filter && shared->filter(gt->sol, shared->data))
+      continue;
+    if (do_ls_filtered(gt->sol, shared->ls_filter, shared->data))
+      continue;
+    double cost = calc_costs(gt->sol, pb->cfg);
+    if (publish_cost(&shared->best_cost, cost)) {
+      swap_solution(&gt->sol, &gt->best);
+      gt->best_cost = cost;
+      gt->best->time = time((time_t *)NULL) - pb->start_time;
+      print_progress(gt->best);
+    }
+  }
+  return NULL;
 }
 
 
@@ -73,6 +161,11 @@ void grasp_construct_routes(Solution* sol, int workers) {
 
 //! Solve the given problem using the GRASP metaheuristic.
 void solve_grasp(Problem* pb, int workers) {
+  if (pb->cfg->threads > 1) {
+    solve_grasp_threaded(pb, workers, (Solution_Filter) NULL,
+                         (State_Filter) NULL, NULL);
+    return;
+  }
   double best_cost = INFINITY;
   double cost = INFINITY;
   Solution* sol = new_solution(pb);
@@ -89,9 +182,57 @@ void solve_grasp(Problem* pb, int workers) {
       pb->sol = sol;
       sol = temp;
     }
-    reset_solution(sol, pb->num_nodes);
+    reset_solution(sol, pb->inst->num_nodes);
     pb->num_solutions++;
   }
   free_solution(sol);
 }
 
+
+//! Solve the given problem using GRASP iterations on cfg->threads threads.
+//! The iterations are independent; each thread owns its solutions and
+//! generator (a non-overlapping stream of the problem's generator). The
+//! threads share the iteration counter (see proceed) and the best cost which
+//! is lowered by compare and swap. As no thread reads pb->sol during the run,
+//! the overall best solution is moved there once all threads are done.
+//! \param filter Optional; allows discarding solutions before their local
+//!        search. It is called concurrently and has to synchronize itself.
+//! \param ls_filter Optional; allows abandoning the local search of
+//!        solutions that reach known states (see do_ls_filtered). Called
+//!        concurrently, too.
+//! \param data Passed to the filters.
+void solve_grasp_threaded(Problem* pb, int workers, Solution_Filter filter,
+                          State_Filter ls_filter, void* data) {
+  int num_threads = (int) pb->cfg->threads;
+  Grasp_Shared shared = {.pb = pb, .workers = workers, .filter = filter,
+    .ls_filter = ls_filter, .data = data, .best_cost = INFINITY};
+  Grasp_Thread threads[num_threads];
+  Rng stream = pb->rng;
+  for (int t = 0; t < num_threads; ++t) {
+    jump_rng(&stream);
+    threads[t] = (Grasp_Thread) {.shared = &shared, .rng = stream,
+      .evaluator = new_move_evaluator(pb), .sol = new_solution(pb),
+      .best = new_solution(pb), .best_cost = INFINITY};
+    threads[t].sol->rng = &threads[t].rng;
+    threads[t].best->rng = &threads[t].rng;
+    threads[t].sol->evaluator = threads[t].evaluator;
+    threads[t].best->evaluator = threads[t].evaluator;
+    if (pthread_create(&threads[t].thread, NULL, run_grasp, &threads[t])) {
+      fprintf(stderr, "ERROR: solve_grasp_threaded: can't create thread\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  double best_cost = INFINITY;
+  for (int t = 0; t < num_threads; ++t) {
+    pthread_join(threads[t].thread, NULL);
+    if (threads[t].best_cost < best_cost) {
+      best_cost = threads[t].best_cost;
+      swap_solution(&pb->sol, &threads[t].best);
+    }
+    free_solution(threads[t].sol);
+    free_solution(threads[t].best);
+    free_move_evaluator(threads[t].evaluator);
+  }
+  pb->sol->rng = &pb->rng;
+  pb->sol->evaluator = pb->evaluator;
+}
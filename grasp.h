@@ -9,8 +9,11 @@
 #define GRASP_H
 
 #include "common.h"
+#include "solution.h"  // for Solution_Filter and State_Filter
 
 void grasp_construct_routes(Solution* sol, int workers);
 void solve_grasp(Problem*, int workers);
+void solve_grasp_threaded(Problem*, int workers, Solution_Filter filter,
+                          State_Filter ls_filter, void* data);
 
 #endif // GRASP_H
@@ -7,6 +7,7 @@
 
 #include <float.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -17,29 +18,77 @@
 #include "route.h"
 #include "solution.h"
 #include "tabu_search.h"
+#include "wrappers.h"
 #include "local_search.h"
 
+//! Evaluates the best-move neighbourhood of a solution on a pool of threads.
+//! The route pairs are partitioned into blocks; block k holds the pairs of
+//! route i = trucks - 1 - k with all routes before it. Every pair starts
+//! from the same move and the pairs' best moves are reduced in block order.
+//! Hence, the result does not depend on the number of threads.
+//! The best move of each pair is kept; as long as the starting move and the
+//! state stay the same, only pairs with a dirty route are evaluated again.
+//! In tabu search, a kept pair is also evaluated again once a better move
+//! it skipped for being tabu is allowed (see Move::tabu_expiry). Moves only
+//! become tabu for the nodes of the last move's (dirty) target route.
+struct move_evaluator {
+  Solution* sol;
+  int state;  //!< Passed to update_move.
+  Move initial;  //!< The move each block starts from.
+  Move* best;  //!< The best move per block.
+  int* updated;  //!< True for each block that found a better move.
+  Move* pairs;  //!< The best move per route pair (see pair_index).
+  int* pair_updated;  //!< True for each pair that found a better move.
+  int max_trucks;  //!< The number of routes pairs is allocated for.
+  bool reuse;  //!< The pairs of clean routes are up to date.
+  int num_blocks;
+  int next_block;  //!< The next block to be claimed by a thread (atomic).
+  int num_threads;  //!< Including the calling thread.
+  int stop;  //!< Set by the calling thread to end the worker threads.
+  pthread_t* threads;
+  pthread_barrier_t start;  //!< Passed when an evaluation starts.
+  pthread_barrier_t done;  //!< Passed when all blocks are evaluated.
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
-static inline double calc_delta_dist_move(double** d, Node* first, Node* last,
-                                          Node* after);
+static inline double calc_delta_dist_move(const Problem* pb, Node* first,
+                                          Node* last, int after_id,
+                                          int succ_id);
 static int delta_is_higher(Move* m, int d_trucks, int d_workers, double d_dist);
 static int empty_route(Solution*, int route_idx);
-static int move_reduces_workers(Route* source, Node* first, Node* last,
+static void evaluate_block(Move_Evaluator*, int block);
+static void evaluate_blocks(Move_Evaluator*);
+static uint64_t hash_state(const Solution*);
+static bool is_known_state(Solution*, int phase, uint64_t* last,
+                           State_Filter known, void* data);
+static int exchange_tails(Route* r1, Route* r2);
+static bool is_feasible_without(const Route* route, int first, int last,
+                                int workers);
+static int move_reduces_workers(const Route* source, int first, int last,
                                 int min_reduction);
+static inline int pair_index(int i, int j);
+static inline bool pair_is_dirty(const Solution*, const bool* scan, int i,
+                                 int j);
+static int relocate_segment(Route*, int max_len);
+static void* run_evaluator(void* evaluator);
+static void start_pass(Solution*, bool* scan, bool all);
 static int swap_node(Route* r1, Route* r2);
 
 
 //! Return the distance difference when moving a sequence of nodes.
-//! \param d The distance matrix.
+//! The sequence is inserted between the nodes with after_id and succ_id.
 //! \return A positive delta if the distance can be reduced by the move.
-static inline double calc_delta_dist_move(double** d, Node* first, Node* last,
-                                          Node* after) {
-  return d[first->prev->id][first->id] + d[last->id][last->next->id] -
-         d[first->prev->id][last->next->id] +
-         d[after->id][after->next->id] -
-         d[after->id][first->id] - d[last->id][after->next->id];
+static inline double calc_delta_dist_move(const Problem* pb, Node* first,
+                                          Node* last, int after_id,
+                                          int succ_id) {
+  return get_dist(pb, first->prev->id, first->id) +
+         get_dist(pb, last->id, last->next->id) -
+         get_dist(pb, first->prev->id, last->next->id) +
+         get_dist(pb, after_id, succ_id) -
+         get_dist(pb, after_id, first->id) -
+         get_dist(pb, last->id, succ_id);
 }
 
 
@@ -94,75 +143,344 @@ static int empty_route(Solution* sol, int route_idx) {
 }
 
 
+//! Evaluate all moves between the given block's route pairs.
+//! Pairs of clean routes are skipped if their previous result can be reused.
+static void evaluate_block(Move_Evaluator* me, int block) {
+  Solution* sol = me->sol;
+  int i = sol->trucks - 1 - block;
+  Move* best = &me->best[block];
+  int updated = 0;
+  *best = me->initial;
+  for (int j = i - 1; j >= 0; --j) {
+    Move* m = &me->pairs[pair_index(i, j)];
+    int* pair_updated = &me->pair_updated[pair_index(i, j)];
+    if (!me->reuse || sol->routes[i]->dirty || sol->routes[j]->dirty ||
+        (m->tabu_expiry && m->tabu_expiry <= sol->pb->tl->iteration)) {
+      *m = me->initial;
+      *pair_updated = update_move(m, sol->routes[j], sol->routes[i],
+                                  me->state, 2);
+      *pair_updated |= update_move(m, sol->routes[i], sol->routes[j],
+                                   me->state, 2);
+      *pair_updated |= update_move(m, sol->routes[j], sol->routes[i],
+                                   me->state, 1);
+      *pair_updated |= update_move(m, sol->routes[i], sol->routes[j],
+                                   me->state, 1);
+    }
+    if (*pair_updated && delta_is_higher(best, m->delta_trucks,
+                                         m->delta_workers, m->delta_dist))
+      *best = *m;
+    updated |= *pair_updated;
+  }
+  me->updated[block] = updated;
+}
+
+
+//! Evaluate blocks until none is left.
+//! Called by all threads of the evaluator.
+static void evaluate_blocks(Move_Evaluator* me) {
+  int block;
+  while ((block = __atomic_fetch_add(&me->next_block, 1, __ATOMIC_RELAXED)) <
+         me->num_blocks)
+    evaluate_block(me, block);
+}
+
+
+//! Return a fingerprint of the solution that depends on the routes' order.
+//! Unlike hash_solution, it distinguishes solutions whose routes are only
+//! ordered differently, as the order steers the local search.
+static uint64_t hash_state(const Solution* sol) {
+  uint64_t hash = 0;
+  for (int i = 0; i < sol->trucks; ++i) {
+    const Route* route = sol->routes[i];
+    hash = mix_hash(hash ^ mix_hash(route->hash ^ (uint64_t) route->workers));
+  }
+  return hash;
+}
+
+
+//! Return true if the solution's state is known to the filter.
+//! The filter is passed the state's fingerprint (see hash_state) combined
+//! with the phase that was completed, as only the remaining phases follow
+//! from the state. If the solution did not change since the previous check,
+//! the filter is not called again; the remaining descent is the same.
+//! \param phase The completed phase (see problem_state).
+//! \param last The fingerprint at the previous check; updated.
+static bool is_known_state(Solution* sol, int phase, uint64_t* last,
+                           State_Filter known, void* data) {
+  if (!known)
+    return false;
+  uint64_t hash = hash_state(sol);
+  if (hash == *last)
+    return false;
+  *last = hash;
+  return known(mix_hash(hash + (uint64_t) phase), data);
+}
+
+
+//! Perform the first feasible 2-opt* move between r1 and r2 that reduces the
+//! total distance.
+//! The routes exchange their tails, ie. the nodes after positions i and j.
+//! Both routes keep their number of workers and at least one customer.
+//! The time windows of the new routes are checked in constant time by
+//! combining the segment summaries.
+//! \return 1 if the distance was reduced, otherwise 0
+static int exchange_tails(Route* r1, Route* r2) {
+  const Problem* pb = r1->pb;
+  double capacity = pb->inst->capacity;
+  int w1 = r1->workers, w2 = r2->workers;
+  update_segments(r1);
+  update_segments(r2);
+  const Route_Array* a1 = &r1->arr;
+  const Route_Array* a2 = &r2->arr;
+  for (int i = 0; i < r1->len - 1; ++i) {  // cut r1 after position i
+    int id1 = a1->ids[i], s1 = a1->ids[i + 1];
+    for (int j = 0; j < r2->len - 1; ++j) {  // cut r2 after position j
+      int id2 = a2->ids[j], s2 = a2->ids[j + 1];
+      if (i + r2->len - 2 - j < 1 || j + r1->len - 2 - i < 1)
+        continue;  // a route would be empty
+      if (!is_neighbour(pb, id1, s2) && !is_neighbour(pb, id2, s1))
+        continue;
+      double savings = get_dist(pb, id1, s1) + get_dist(pb, id2, s2) -
+                       get_dist(pb, id1, s2) - get_dist(pb, id2, s1);
+      if (savings <= MIN_DELTA)
+        continue;
+      Segment new1 = concat_segments(*get_prefix(r1, w1, i),
+                                     get_cost(pb, w1, id1, s2),
+                                     *get_suffix(r2, w1, j + 1));
+      if (!new1.feasible || new1.load > capacity)
+        continue;
+      Segment new2 = concat_segments(*get_prefix(r2, w2, j),
+                                     get_cost(pb, w2, id2, s1),
+                                     *get_suffix(r1, w2, i + 1));
+      if (!new2.feasible || new2.load > capacity)
+        continue;
+      Node* after1 = a1->nodes[i];
+      Node* after2 = a2->nodes[j];
+      Node* tail1 = (i < r1->len - 2) ? a1->nodes[i + 1] : (Node*) NULL;
+      Node* tail2 = (j < r2->len - 2) ? a2->nodes[j + 1] : (Node*) NULL;
+      Node* last1 = r1->tail->prev;
+      Node* last2 = r2->tail->prev;
+      if (tail1) remove_nodes_noupdate(r1, tail1, last1);
+      if (tail2) remove_nodes_noupdate(r2, tail2, last2);
+      if (tail2) add_nodes_noupdate(r1, tail2, last2, after1);
+      if (tail1) add_nodes_noupdate(r2, tail1, last1, after2);
+      calc_ests(r1, r1->nodes, w1);
+      calc_lsts(r1, r1->tail, w1);
+      calc_ests(r2, r2->nodes, w2);
+      calc_lsts(r2, r2->tail, w2);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+//! Return true if the route's time windows hold for the given number of
+//! workers once the nodes at the positions first to last are removed.
+//! The route's segment summaries have to be up to date (see update_segments);
+//! the check then takes constant time.
+static bool is_feasible_without(const Route* route, int first, int last,
+                                int workers) {
+  const int* ids = route->arr.ids;
+  return concat_segments(*get_prefix(route, workers, first - 1),
+                         get_cost(route->pb, workers, ids[first - 1],
+                                  ids[last + 1]),
+                         *get_suffix(route, workers, last + 1)).feasible;
+}
+
+
 //! Return the number of workers that can be removed by removing first to last.
-//! \param first The first node in a list of nodes considered to be moved away.
-//! \param last The last node in a list of nodes considered to be moved away.
+//! The source route is not modified.
+//! \param first The position of the first node considered to be moved away.
+//! \param last The position of the last node considered to be moved away.
 //! \param min_reduction Only investigate reductions >= min_reduction.
 //! \return The number of workers that can be reduced.
-static int move_reduces_workers(Route* source, Node* first, Node* last,
+static int move_reduces_workers(const Route* source, int first, int last,
                                 int min_reduction) {
   int max_reduction = source->workers - 1;  // one worker (driver) is needed
   if (!min_reduction) min_reduction++;
   int reduction = 0;
-  first->prev->next = last->next;
-  last->next->prev = first->prev;
   while ((min_reduction <= max_reduction) &&
-         is_feasible_with(source, source->workers - min_reduction))
+         is_feasible_without(source, first, last,
+                             source->workers - min_reduction))
     reduction = min_reduction++;
-  first->prev->next = first;
-  last->next->prev = last;
   return reduction;
 }
 
 
+//! Return the index of the pair of the routes i and j (j < i).
+static inline int pair_index(int i, int j) {
+  return i * (i - 1) / 2 + j;
+}
+
+
+//! Return true if the pair of the routes i and j has to be scanned in the
+//! current pass, ie. if one of the routes changed since the previous pass
+//! started (see start_pass).
+static inline bool pair_is_dirty(const Solution* sol, const bool* scan, int i,
+                                 int j) {
+  const Route* ri = sol->routes[i];
+  const Route* rj = sol->routes[j];
+  return ri->dirty || rj->dirty || scan[ri - sol->route_pool] ||
+         scan[rj - sol->route_pool];
+}
+
+
+//! Perform the first feasible or-opt move on the route that reduces the total
+//! distance.
+//! A sequence of up to max_len consecutive nodes is moved to another position
+//! of the same route (max_len = 1 relocates single nodes). The nodes between
+//! the sequence's old and new position are summarized incrementally, so each
+//! new position's time windows are checked in constant time.
+//! \return 1 if the distance was reduced, otherwise 0
+static int relocate_segment(Route* route, int max_len) {
+  const Problem* pb = route->pb;
+  int w = route->workers;
+  int end = route->len - 1;  // the closing depot
+  update_segments(route);
+  const Route_Array* a = &route->arr;
+  const int* ids = a->ids;
+  for (int len = 1; len <= max_len; ++len) {
+    for (int p = 1; p + len - 1 < end; ++p) {  // the sequence is p to q
+      int q = p + len - 1;
+      Node* first = a->nodes[p];
+      Node* last = a->nodes[q];
+      Segment seq = get_segment(pb, first, last, w);
+      Segment mid = node_segment(a->nodes[p - 1]);  // nodes k + 1 to p - 1
+      for (int k = p - 2; k >= 0; --k) {  // insert after k (before p)
+        if (k < p - 2)
+          mid = concat_segments(node_segment(a->nodes[k + 1]),
+                                get_cost(pb, w, ids[k + 1], ids[k + 2]), mid);
+        if (calc_delta_dist_move(pb, first, last, ids[k], ids[k + 1]) <=
+            MIN_DELTA)
+          continue;
+        Segment s = concat_segments(*get_prefix(route, w, k),
+                                    get_cost(pb, w, ids[k], ids[p]), seq);
+        s = concat_segments(s, get_cost(pb, w, ids[q], ids[k + 1]), mid);
+        s = concat_segments(s, get_cost(pb, w, ids[p - 1], ids[q + 1]),
+                            *get_suffix(route, w, q + 1));
+        if (s.feasible) {
+          Node* after = a->nodes[k];
+          remove_nodes_noupdate(route, first, last);
+          add_nodes_noupdate(route, first, last, after);
+          calc_ests(route, route->nodes, w);
+          calc_lsts(route, route->tail, w);
+          return 1;
+        }
+      }
+      if (q + 1 == end)
+        continue;
+      mid = node_segment(a->nodes[q + 1]);  // nodes q + 1 to k
+      for (int k = q + 1; k < end; ++k) {  // insert after k (after q)
+        if (k > q + 1)
+          mid = concat_segments(mid, get_cost(pb, w, ids[k - 1], ids[k]),
+                                node_segment(a->nodes[k]));
+        if (calc_delta_dist_move(pb, first, last, ids[k], ids[k + 1]) <=
+            MIN_DELTA)
+          continue;
+        Segment s = concat_segments(*get_prefix(route, w, p - 1),
+                                    get_cost(pb, w, ids[p - 1], ids[q + 1]),
+                                    mid);
+        s = concat_segments(s, get_cost(pb, w, ids[k], ids[p]), seq);
+        s = concat_segments(s, get_cost(pb, w, ids[q], ids[k + 1]),
+                            *get_suffix(route, w, k + 1));
+        if (s.feasible) {
+          Node* after = a->nodes[k];
+          remove_nodes_noupdate(route, first, last);
+          add_nodes_noupdate(route, first, last, after);
+          calc_ests(route, route->nodes, w);
+          calc_lsts(route, route->tail, w);
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+
+//! Evaluate blocks each time the calling thread starts an evaluation.
+static void* run_evaluator(void* evaluator) {
+  Move_Evaluator* me = (Move_Evaluator*) evaluator;
+  while (1) {
+    pthread_barrier_wait(&me->start);
+    if (me->stop)
+      break;
+    evaluate_blocks(me);
+    pthread_barrier_wait(&me->done);
+  }
+  return NULL;
+}
+
+
+//! Prepare a pass over the solution's route pairs.
+//! Pairs of routes that did not change since the previous pass can be skipped
+//! as their evaluation would yield the same result.
+//! \param scan Set for the slot of each route that changed (or for all
+//! routes if all is true).
+static void start_pass(Solution* sol, bool* scan, bool all) {
+  for (int i = 0; i < sol->trucks; ++i) {
+    Route* route = sol->routes[i];
+    scan[route - sol->route_pool] = all || route->dirty;
+    route->dirty = false;
+  }
+}
+
+
 //! Perform the first feasible and useful swap operation between r1 and r2.
 //! A swap is useful if it decreases the total distance.
 //! \return 1 if the distance was reduced, otherwise 0
 static int swap_node(Route* r1, Route* r2) {
   double savings = 0.0;
-  double capacity = r1->pb->capacity;
-  double** d = r1->pb->c_m[0];  // distance
-  double** c_m1 = r1->pb->c_m[r1->workers];  // driving + service time
-  double** c_m2 = r2->pb->c_m[r2->workers];  // driving + service time
-  Node* n1 = r1->nodes->next;  // start w/ the first node after the depot
-  Node* n2 = r2->nodes->next;
-  while (n1->next) {
-    while (n2->next) {
+  double capacity = r1->pb->inst->capacity;
+  const Problem* pb = r1->pb;
+  const Route_Array* a1 = &r1->arr;
+  const Route_Array* a2 = &r2->arr;
+  int w1 = r1->workers;  // driving + service time on r1
+  int w2 = r2->workers;  // driving + service time on r2
+  // start w/ the first node after the depot and stop before the closing one
+  for (int i = 1; i < r1->len - 1; ++i) {
+    int p1 = a1->ids[i - 1], id1 = a1->ids[i], s1 = a1->ids[i + 1];
+    for (int j = 1; j < r2->len - 1; ++j) {
+      int p2 = a2->ids[j - 1], id2 = a2->ids[j], s2 = a2->ids[j + 1];
       // check capacity
-      if (capacity < r1->load - n1->demand + n2->demand ||
-        capacity < r2->load - n2->demand + n1->demand) {
-        n2 = n2->next;
+      if (capacity < r1->load - a1->demand[i] + a2->demand[j] ||
+        capacity < r2->load - a2->demand[j] + a1->demand[i]) {
         continue;
       }
       // check time windows
-      n1->aest_cache = max(n2->prev->aest + c_m2[n2->prev->id][n1->id],
-                            n1->est);  //  when do we get to n1 on r2
-      n2->aest_cache = max(n1->prev->aest + c_m1[n1->prev->id][n2->id],
-                            n2->est);  //  when do we get to n2 on r1
-      if (n1->aest_cache <= n1->lst && n2->aest_cache <= n2->lst) {
-        n1->next->aest_cache = max(n2->aest_cache +
-                                    c_m1[n2->id][n1->next->id],
-                                    n1->next->est);
-        n2->next->aest_cache = max(n1->aest_cache +
-                                    c_m2[n1->id][n2->next->id],
-                                    n2->next->est);
-        if (n1->next->aest_cache <= n1->next->alst &&
-            n2->next->aest_cache <= n2->next->alst) {
+      double aest1 = max(a2->aest[j - 1] + get_cost(pb, w2, p2, id1),
+                         a1->est[i]);  //  when do we get to n1 on r2
+      double aest2 = max(a1->aest[i - 1] + get_cost(pb, w1, p1, id2),
+                         a2->est[j]);  //  when do we get to n2 on r1
+      if (aest1 <= a1->lst[i] && aest2 <= a2->lst[j]) {
+        double aest_succ1 = max(aest2 + get_cost(pb, w1, id2, s1),
+                                a1->est[i + 1]);
+        double aest_succ2 = max(aest1 + get_cost(pb, w2, id1, s2),
+                                a2->est[j + 1]);
+        if (aest_succ1 <= a1->alst[i + 1] && aest_succ2 <= a2->alst[j + 1]) {
           // check savings
-          savings = d[n1->prev->id][n1->id] + d[n1->id][n1->next->id] +
-                    d[n2->prev->id][n2->id] + d[n2->id][n2->next->id] -
-                    d[n1->prev->id][n2->id] - d[n2->id][n1->next->id] -
-                    d[n2->prev->id][n1->id] - d[n1->id][n2->next->id];
+          savings = get_dist(pb, p1, id1) +
+                    get_dist(pb, id1, s1) +
+                    get_dist(pb, p2, id2) +
+                    get_dist(pb, id2, s2) -
+                    get_dist(pb, p1, id2) -
+                    get_dist(pb, id2, s1) -
+                    get_dist(pb, p2, id1) -
+                    get_dist(pb, id1, s2);
           if (savings > MIN_DELTA) {
+            Node* n1 = a1->nodes[i];
+            Node* n2 = a2->nodes[j];
+            n1->aest_cache = aest1;  // swap takes the new aests from the cache
+            n2->aest_cache = aest2;
+            n1->next->aest_cache = aest_succ1;
+            n2->next->aest_cache = aest_succ2;
             swap(r1, r2, n1, n2);
             return 1;
           }
         }
       }
-      n2 = n2->next;
     }
-    n2 = r2->nodes->next;
-    n1 = n1->next;
   }
   return 0;
 }
@@ -175,25 +493,25 @@ static int swap_node(Route* r1, Route* r2) {
 //! Try to reduce trucks by attempting to move all of a truck's nodes.
 //! As the moves are generally increasing the distance, this would reduce the
 //! solution quality. Hence, the "result" is only committed if all the nodes
-//! can be removed and not just some.
+//! can be removed and not just some; otherwise, the moves are rolled back.
 int brute_reduce_trucks(Solution** sol_ptr) {
   Solution* sol = *sol_ptr;
-  Solution* clone = clone_solution(sol);
   int reduced = 0, improved = 0;
   do {
-    for (int i = 0; i < clone->trucks; ++i) {
-      reduced = empty_route(clone, i);
+    checkpoint_solution(sol);
+    for (int i = 0; i < sol->trucks; ++i) {
+      reduced = empty_route(sol, i);
       if (reduced) {
-        remove_route(clone, i);
-        free_solution(sol);
-        sol = clone_solution(clone);
-        *sol_ptr = sol;  // set sol_ptr to the new solution's address
+        remove_route(sol, i);
         improved = 1;
         break;
       }
     }
+    if (reduced)
+      commit_solution(sol);
+    else
+      rollback_solution(sol);
   } while (reduced);
-  free_solution(clone);
   return improved;
 }
 
@@ -201,34 +519,132 @@ int brute_reduce_trucks(Solution** sol_ptr) {
 //! Perform a full local search.
 //! First reduce trucks and distance, then workers and distance, then distance.
 Solution* do_ls(Solution *sol) {
+  do_ls_filtered(sol, (State_Filter) NULL, NULL);
+  return sol;
+}
+
+
+//! Perform a full local search unless it reaches a known state.
+//! The filter is passed the states the phases of the search lead to,
+//! including the local optimum. The remaining phases only depend on the
+//! state (the routes in their order) and the completed phase. Hence, once a
+//! search reaches a state another search already continued from after the
+//! same phase, it would end in that search's local optimum and is abandoned.
+//! \param known Optional; returns nonzero if the given state is known and
+//!        records it otherwise.
+//! \param data Passed to the filter.
+//! \return 1 if the search was abandoned, otherwise 0.
+int do_ls_filtered(Solution* sol, State_Filter known, void* data) {
+  uint64_t last = known ? hash_state(sol) : 0;
   if (sol->pb->cfg->do_ls) {
     sol = reduce_trucks(sol);
-    if (sol->pb->cfg->max_workers > 1)
+    if (is_known_state(sol, REDUCE_TRUCKS, &last, known, data))
+      return 1;
+    if (sol->pb->cfg->max_workers > 1) {
       reduce_workers(sol);
-    // reduce_distance(sol);
+      if (is_known_state(sol, REDUCE_WORKERS, &last, known, data))
+        return 1;
+    }
+    reduce_distance(sol);
+    return is_known_state(sol, REDUCE_DISTANCE, &last, known, data);
   } else  // if local search is disabled, at least unused workers are removed
     for (int i = 0; i < sol->trucks; ++i) {
       reduce_service_workers(sol->routes[i]);
     }
-  return sol;
+  return 0;
+}
+
+
+//! Update the given move if there is a better move between any two routes.
+//! The moves are evaluated by the evaluator's threads; the solution must not
+//! be modified meanwhile. Afterwards, all routes are clean.
+//! \return 1 if the move was updated, otherwise 0.
+int find_best_move(Move_Evaluator* me, Move* m, int state) {
+  int updated = 0;
+  Solution* sol = me->sol;
+  me->reuse = me->reuse && (state == me->state) && !m->first &&
+              (m->improving == me->initial.improving);
+  if (sol->trucks > me->max_trucks && sol->trucks > 1) {
+    free(me->pairs);
+    free(me->pair_updated);
+    size_t num_pairs = (size_t) pair_index(sol->trucks, 0);
+    me->pairs = (Move*) s_malloc(num_pairs * sizeof(Move));
+    me->pair_updated = (int*) s_malloc(num_pairs * sizeof(int));
+    me->max_trucks = sol->trucks;
+    me->reuse = false;
+  }
+  me->state = state;
+  me->initial = *m;
+  me->num_blocks = sol->trucks > 1 ? sol->trucks - 1 : 0;
+  me->next_block = 0;
+  if (state >= REDUCE_WORKERS) {  // the threads only read the summaries
+    for (int r = 0; r < sol->trucks; ++r)
+      update_segments(sol->routes[r]);
+  }
+  if (me->num_threads > 1 && me->num_blocks > 1) {
+    pthread_barrier_wait(&me->start);
+    evaluate_blocks(me);
+    pthread_barrier_wait(&me->done);
+  } else {
+    evaluate_blocks(me);
+  }
+  for (int block = 0; block < me->num_blocks; ++block) {
+    const Move* best = &me->best[block];
+    if (me->updated[block] && delta_is_higher(m, best->delta_trucks,
+                                              best->delta_workers,
+                                              best->delta_dist))
+      *m = *best;
+    updated |= me->updated[block];
+  }
+  for (int r = 0; r < sol->trucks; ++r)
+    sol->routes[r]->dirty = false;
+  me->reuse = true;
+  return updated;
+}
+
+
+//! Stop the evaluator's threads and free its memory.
+void free_move_evaluator(Move_Evaluator* me) {
+  if (me->num_threads > 1) {
+    me->stop = 1;
+    pthread_barrier_wait(&me->start);
+    for (int t = 0; t < me->num_threads - 1; ++t)
+      pthread_join(me->threads[t], NULL);
+    pthread_barrier_destroy(&me->start);
+    pthread_barrier_destroy(&me->done);
+  }
+  free(me->threads);
+  free(me->best);
+  free(me->updated);
+  free(me->pairs);
+  free(me->pair_updated);
+  free(me);
 }
 
 
 //! Perform all feasible and useful move operations.
 //! A move is useful if it decreases the number of trucks or workers or the
 //! total distance.
+//! After the first pass, only pairs with a route that changed are scanned.
 //! \return 1 if at least one move was performed, otherwise 0.
 int move_all(Solution* sol, int state) {
   if (sol->pb->cfg->best_moves)
     return move_all_best(sol, state);
   int len = (int) sol->pb->cfg->max_move;
   int updated = 0, success = 0, delta_trucks = 0;
+  bool* scan = (bool*) s_malloc((size_t) sol->pb->inst->num_nodes *
+                                sizeof(bool));
   Move m; init_move(&m, IMPROVING);
   while (len) {
+    bool all = true;
     do {
       updated = 0;
+      start_pass(sol, scan, all);
+      all = false;
       for (int i = sol->trucks - 1; i >= 1; --i) {
         for (int j = i - 1; j >= 0; --j) {
+          if (!pair_is_dirty(sol, scan, i, j))
+            continue;
           updated |= update_move(&m, sol->routes[j], sol->routes[i], state,
                                  len);
           delta_trucks = m.delta_trucks;
@@ -245,6 +661,7 @@ int move_all(Solution* sol, int state) {
     } while (updated);
     len--;
   }
+  free(scan);
   return success;
 }
 
@@ -252,20 +669,15 @@ int move_all(Solution* sol, int state) {
 //! Perform all best move operations.
 //! A move is considered best if it is feasible and decreases the cost for
 //! trucks, workers and the total distance more than any other feasible move.
-//! Only inter-route moves are considered.
+//! Only inter-route moves are considered. The moves are evaluated by the
+//! solution's evaluator.
 int move_all_best(Solution* sol, int state) {
   int updated = 0, success = 0;
+  Move_Evaluator* me = sol->evaluator;
+  reset_move_evaluator(me, sol);
   Move m; init_move(&m, IMPROVING);
   do {
-    updated = 0;
-    for (int i = sol->trucks - 1; i >= 1; --i) {
-      for (int j = i - 1; j >= 0; --j) {
-        updated |= update_move(&m, sol->routes[j], sol->routes[i], state, 2);
-        updated |= update_move(&m, sol->routes[i], sol->routes[j], state, 2);
-        updated |= update_move(&m, sol->routes[j], sol->routes[i], state, 1);
-        updated |= update_move(&m, sol->routes[i], sol->routes[j], state, 1);
-      }
-    }
+    updated = find_best_move(me, &m, state);
     perform_move(sol, &m);
     success |= updated;
   } while (updated);
@@ -273,6 +685,40 @@ int move_all_best(Solution* sol, int state) {
 }
 
 
+//! Return a new evaluator for the best moves of the problem's solutions.
+//! It uses cfg->ls_threads threads including the calling thread. Before
+//! use, it has to be reset to the solution to evaluate.
+Move_Evaluator* new_move_evaluator(const Problem* pb) {
+  Move_Evaluator* me = (Move_Evaluator*) s_malloc(sizeof(Move_Evaluator));
+  size_t max_blocks = (size_t) pb->inst->num_nodes;
+  me->sol = (Solution*) NULL;
+  me->best = (Move*) s_malloc(max_blocks * sizeof(Move));
+  me->updated = (int*) s_malloc(max_blocks * sizeof(int));
+  me->pairs = (Move*) NULL;  // allocated by find_best_move
+  me->pair_updated = (int*) NULL;
+  me->max_trucks = 0;
+  me->reuse = false;
+  me->num_blocks = 0;
+  me->next_block = 0;
+  me->num_threads = (int) pb->cfg->ls_threads;
+  me->stop = 0;
+  me->threads = (pthread_t*) NULL;
+  if (me->num_threads < 2)
+    return me;
+  me->threads = (pthread_t*) s_malloc((size_t) (me->num_threads - 1) *
+                                      sizeof(pthread_t));
+  pthread_barrier_init(&me->start, NULL, (unsigned) me->num_threads);
+  pthread_barrier_init(&me->done, NULL, (unsigned) me->num_threads);
+  for (int t = 0; t < me->num_threads - 1; ++t) {
+    if (pthread_create(&me->threads[t], NULL, run_evaluator, me)) {
+      fprintf(stderr, "ERROR: new_move_evaluator: can't create thread\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return me;
+}
+
+
 //! Perform the given move and reset it afterwards.
 void perform_move(Solution* sol, Move* m) {
   if (!m->first)
@@ -294,10 +740,43 @@ void perform_move(Solution* sol, Move* m) {
 }
 
 
-// TODO: implement
-// void reduce_distance(Solution *sol)
-// {
-// }
+//! Try to reduce the total distance without using more trucks or workers.
+//! Routes exchange their tails (2-opt*) and sequences of up to max_optimize
+//! nodes are moved within their route (or-opt) until neither finds an
+//! improvement. Workers that become superfluous are removed afterwards.
+//! After the first pass, only routes and pairs that changed are scanned.
+//! \return 1 if the distance was reduced, otherwise 0.
+int reduce_distance(Solution* sol) {
+  int max_len = (int) sol->pb->cfg->max_optimize;
+  int improved = 0, success = 0;
+  bool all = true;
+  if (!max_len)
+    return 0;
+  bool* scan = (bool*) s_malloc((size_t) sol->pb->inst->num_nodes *
+                                sizeof(bool));
+  do {
+    improved = 0;
+    start_pass(sol, scan, all);
+    all = false;
+    for (int i = 0; i < sol->trucks; ++i) {
+      Route* route = sol->routes[i];
+      if (scan[route - sol->route_pool] || route->dirty)
+        while (relocate_segment(route, max_len))
+          improved = 1;
+    }
+    for (int i = sol->trucks - 1; i >= 1; --i) {
+      for (int j = i - 1; j >= 0; --j) {
+        if (pair_is_dirty(sol, scan, i, j))
+          improved |= exchange_tails(sol->routes[i], sol->routes[j]);
+      }
+    }
+    success |= improved;
+  } while (improved);
+  free(scan);
+  for (int i = 0; i < sol->trucks; ++i)
+    reduce_service_workers(sol->routes[i]);
+  return success;
+}
 
 
 //! Try to reduce the number of trucks used by the solution.
@@ -333,24 +812,40 @@ void reduce_workers(Solution *sol) {
 }
 
 
+//! Point the given evaluator to the given solution.
+//! Nothing is reused from the evaluator's previous moves.
+void reset_move_evaluator(Move_Evaluator* me, Solution* sol) {
+  me->sol = sol;
+  me->reuse = false;
+}
+
+
 //! Perform all feasible and useful swap operations.
 //! A swap is useful if it decreases the number of workers or the
 //! total distance.
+//! After the first pass, only pairs with a route that changed are scanned.
 int swap_all(Solution* sol) {
   long int len = sol->pb->cfg->max_swap;
   int improved = 0;
   int success = 0;
+  bool all = true;
+  bool* scan = (bool*) s_malloc((size_t) sol->pb->inst->num_nodes *
+                                sizeof(bool));
   do {
     improved = 0;
+    start_pass(sol, scan, all);
+    all = false;
     if (len >= 1) {
       for (int i = sol->trucks - 1; i >= 1; --i) {
         for (int j = i - 1; j >= 0; --j) {
-          improved |= swap_node(sol->routes[i], sol->routes[j]);
+          if (pair_is_dirty(sol, scan, i, j))
+            improved |= swap_node(sol->routes[i], sol->routes[j]);
         }
       }
     }
     success |= improved;
   } while (improved);
+  free(scan);
   return success;
 }
 
@@ -370,42 +865,50 @@ int update_move(Move* m, Route* source, Route* target, int state, int len) {
   double delta_dist = 0.0;
   if ((m->delta_trucks == 1) && !delta_trucks)
     return 0;  // truck can't be reduced but is reduced in the best move
-  Node* after = target->nodes;
+  bool check_workers = (state >= REDUCE_WORKERS) && !delta_trucks;
+  if (check_workers)
+    update_segments(source);  // a no-op while evaluating best moves
+  const Route_Array* a = &target->arr;
   Node* first = source->nodes->next;
   Node* last = first;
+  int span = len - 1;  // positions from first to last
   while (--len)
     last = last->next;
-  while (last->next) {  // n is not the closing depot
-    if (target->pb->capacity < target->load + sum_demands(first, last)) {
-      first = first->next;
-      last = last->next;
+  for (int pos = 1; last->next;  // pos of first; stop at the closing depot
+       ++pos, first = first->next, last = last->next) {
+    Segment seq = get_segment(source->pb, first, last, target->workers);
+    if (target->pb->inst->capacity < target->load + seq.load)
       continue;
-    }
-    if ((state >= REDUCE_WORKERS) && !delta_trucks)
-      delta_workers = move_reduces_workers(source, first, last,
+    if (check_workers)
+      delta_workers = move_reduces_workers(source, pos, pos + span,
                                            m->delta_workers);
-    while (after != target->tail) {
-      delta_dist = calc_delta_dist_move(source->pb->c_m[0], first, last,
-                                        after);
+    for (int i = 0; i < target->len - 1; ++i) {  // insert after node i
+      if (!is_neighbour(source->pb, first->id, a->ids[i]) &&
+          !is_neighbour(source->pb, last->id, a->ids[i + 1]))
+        continue;
+      if (!can_follow(source->pb, target->workers, a->ids[i], first->id) ||
+          !can_follow(source->pb, target->workers, last->id, a->ids[i + 1]))
+        continue;  // statically infeasible; see can_insert
+      delta_dist = calc_delta_dist_move(source->pb, first, last, a->ids[i],
+                                        a->ids[i + 1]);
       if (delta_is_higher(m, delta_trucks, delta_workers, delta_dist)) {
-        if (can_insert(target, first, last, after)) {
+        if (can_insert(target, &seq, first->id, last->id, i)) {
           Move candidate = {.source = source, .target = target, .first = first,
-            .last = last, .after = after, .delta_dist = delta_dist,
+            .last = last, .after = a->nodes[i], .delta_dist = delta_dist,
             .delta_trucks = delta_trucks, .delta_workers = delta_workers,
-            .improving = m->improving};
-          if (!is_move_tabu(source->pb->tl, &candidate)) {
+            .improving = m->improving, .tabu_expiry = m->tabu_expiry};
+          unsigned long expiry = get_tabu_expiry(source->pb->tl, &candidate);
+          if (expiry <= source->pb->tl->iteration) {
             *m = candidate;
             if (!source->pb->cfg->best_moves)
               return 1;
             updated = 1;
+          } else if (!m->tabu_expiry || expiry < m->tabu_expiry) {
+            m->tabu_expiry = expiry;  // see move_evaluator::pairs
           }
         }
       }
-      after = after->next;
     }
-    after = target->nodes;
-    first = first->next;
-    last = last->next;
   }
   return updated;
 }
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 
 #include "common.h"
+#include "solution.h"  // for State_Filter
 
 static const int NON_IMPROVING = 0;
 static const int IMPROVING = 1;
@@ -26,6 +27,9 @@ struct move {
   int delta_workers;  //!< Positive delta implies savings.
   double delta_dist;  //!< Positive delta implies savings.
   int improving;  //!< Only allow improving moves.
+  //! The earliest iteration a better but tabu move becomes allowed again
+  //! (0 if no such move was skipped).
+  unsigned long tabu_expiry;
   Move* next;  //!< Doubly linked list allowing to keep sorted list of moves.
   Move* prev;
 };
@@ -33,13 +37,18 @@ struct move {
 
 int brute_reduce_trucks(Solution**);
 Solution* do_ls(Solution*) __attribute__ ((warn_unused_result));
+int do_ls_filtered(Solution*, State_Filter known, void* data);
+int find_best_move(Move_Evaluator*, Move* m, int state);
+void free_move_evaluator(Move_Evaluator*);
 int move_all(Solution*, int state);
 int move_all_best(Solution*, int state);
+Move_Evaluator* new_move_evaluator(const Problem*);
 void perform_move(Solution*, Move*);
-void reduce_distance(Solution*);
+int reduce_distance(Solution*);
 Solution* reduce_trucks(Solution*)
   __attribute__ ((warn_unused_result));
 void reduce_workers(Solution*);
+void reset_move_evaluator(Move_Evaluator*, Solution*);
 int swap_all(Solution* sol);
 int update_move(Move* m, Route* source, Route* target, int state, int len);
 
@@ -53,12 +62,14 @@ static inline void init_move(Move* m, bool improving) {
     *m = (Move) {.source = (Route*) NULL, .target = (Route*) NULL,
       .first = (Node*) NULL, .last = (Node*) NULL, .after = (Node*) NULL,
       .delta_trucks = 0, .delta_workers = 0, .delta_dist = 0.0,
-      .improving = improving, .next = (Move*) NULL, .prev = (Move*) NULL};
+      .improving = improving, .tabu_expiry = 0, .next = (Move*) NULL,
+      .prev = (Move*) NULL};
   else
     *m = (Move) {.source = (Route*) NULL, .target = (Route*) NULL,
       .first = (Node*) NULL, .last = (Node*) NULL, .after = (Node*) NULL,
       .delta_trucks = 0, .delta_workers = 0, .delta_dist = -DBL_MAX,
-      .improving = improving, .next = (Move*) NULL, .prev = (Move*) NULL};
+      .improving = improving, .tabu_expiry = 0, .next = (Move*) NULL,
+      .prev = (Move*) NULL};
 }
 
 #endif
@@ -5,9 +5,14 @@
  *
  */
 
-#include <cstdlib>  // srand48, exit etc.
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>  // exit etc.
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options/options_description.hpp>
@@ -37,12 +42,66 @@ static std::string find_default_config_file() {
   return filepath.string();
 }
 
+//! Solve the instance stored in file and return its result.
+//! The configuration is shared by all jobs and hence not modified.
+//! \param output serializes the output of concurrently running jobs
+//! \return the instance's result; NULL if the file is not readable
+static Resultlist* solve_file(const std::string& file, Config* cfg,
+                              std::mutex& output) {
+  Problem* pb = get_problem(file.c_str(), cfg);
+  if (!pb) {
+    return (Resultlist*) NULL;
+  }
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  assert_feasibility(pb->sol);
+  {
+    std::lock_guard<std::mutex> guard(output);
+    if (cfg->verbosity >= BASIC_DEBUG)
+      fprint_solution(stdout, pb->sol, cfg, (int) cfg->verbosity);
+    save_solution_details(pb->sol, cfg);
+  }
+  Resultlist* result = add_result(pb);
+  free_problem(pb);
+  return result;
+}
+
+//! Solve the given files on a pool of cfg->jobs threads.
+//! Every job takes the next unsolved file until all files are solved.
+//! \return the list of results in the same order as the files
+static Resultlist* solve_files(const std::vector<std::string>& files,
+                               Config* cfg) {
+  std::vector<Resultlist*> solved(files.size(), (Resultlist*) NULL);
+  std::atomic<size_t> next(0);
+  std::mutex output;
+  auto job = [&]() {
+    for (size_t i = next++; i < files.size(); i = next++) {
+      solved[i] = solve_file(files[i], cfg, output);
+    }
+  };
+  size_t jobs = std::min(files.size(), (size_t) cfg->jobs);
+  std::vector<std::thread> pool;
+  for (size_t j = 1; j < jobs; ++j) {
+    pool.emplace_back(job);
+  }
+  job();  // the main thread is the first job
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  Resultlist* results = (Resultlist*) NULL;
+  Resultlist** tail = &results;
+  for (auto result : solved) {
+    if (result) {
+      *tail = result;
+      tail = &result->next;
+    }
+  }
+  return results;
+}
+
 
 int main (int argc, char** argv) {
   try {
-    int first = 1;  // TODO: refactor to use proper c++ vector instead if ResultList
     Resultlist* results = (Resultlist*) NULL;
-    Resultlist* tail = (Resultlist*) NULL;
     Config* cfg = get_config((char*) find_default_config_file().c_str());
 
     po::options_description visible("Usage: " + program_name +  " [options] file... ");
@@ -51,8 +110,15 @@ int main (int argc, char** argv) {
     visible.add_options()
       ("ants", po::value<long int>()->default_value(cfg->ants),
        "number of ants (0 for automatic)")
+      ("cache-max-bytes",
+       po::value<long int>()->default_value(cfg->cache_max_bytes),
+       "memory bound of the solution cache (0 for unbounded)")
       ("deterministic,d", "Use deterministic algorithm (for debugging)")
       ("help,h", "Display this help message")
+      ("jobs,j", po::value<long int>()->default_value(cfg->jobs),
+       "number of instances solved concurrently")
+      ("ls-threads", po::value<long int>()->default_value(cfg->ls_threads),
+       "number of threads evaluating the best moves")
       ("metaheuristic,m",
       po::value<std::string>()->default_value(METAHEURISTICS[cfg->metaheuristic]),
       "use the given metaheuristic")
@@ -64,6 +130,8 @@ int main (int argc, char** argv) {
       "Runtime per instance (in seconds)\nset to 0 to disable this limit")
       ("seed", po::value<long int>()->default_value(cfg->seed),
       "Select the seed for the pseudo random number generator (for debugging)")
+      ("threads", po::value<long int>()->default_value(cfg->threads),
+       "ACO and GRASP: number of threads constructing solutions")
       ("verbosity,v", po::value<long int>()->default_value(cfg->verbosity),
       "Set the verbosity level")
       ("version", "Display the version number");
@@ -100,10 +168,29 @@ int main (int argc, char** argv) {
 
     cfg->ants = vm["ants"].as<long int>();
     cfg->ants_dynamic = !cfg->ants;  // dynamic only if ants is set to 0
+    cfg->cache_max_bytes = vm["cache-max-bytes"].as<long int>();
+    if (cfg->cache_max_bytes < 0) {
+      std::cerr << "ERROR: cache-max-bytes has to be >= 0" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    cfg->jobs = vm["jobs"].as<long int>();
+    if (cfg->jobs < 1) {
+      std::cerr << "ERROR: jobs has to be >= 1" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    cfg->ls_threads = vm["ls-threads"].as<long int>();
+    if (cfg->ls_threads < 1) {
+      std::cerr << "ERROR: ls-threads has to be >= 1" << std::endl;
+      exit(EXIT_FAILURE);
+    }
     cfg->rho = vm["rho"].as<double>();
     cfg->runtime = vm["runtime"].as<long int>();
     cfg->seed = vm["seed"].as<long int>();
-    srand48(cfg->seed);  // initialize randomizer
+    cfg->threads = vm["threads"].as<long int>();
+    if (cfg->threads < 1) {
+      std::cerr << "ERROR: threads has to be >= 1" << std::endl;
+      exit(EXIT_FAILURE);
+    }
     cfg->verbosity = vm["verbosity"].as<long int>();
 
     if (!cfg->parallel) {
@@ -112,26 +199,7 @@ int main (int argc, char** argv) {
 
     if(vm.count("input-files")){
       std::vector<std::string> files = vm["input-files"].as<std::vector<std::string>>();
-      for (auto file : files) {
-        Problem* pb = get_problem(file.c_str(), cfg);
-        if (!pb) {
-          continue;
-        }
-        solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
-        assert_feasibility(pb->sol);
-        if (cfg->verbosity >= BASIC_DEBUG)
-          fprint_solution(stdout, pb->sol, cfg, (int) cfg->verbosity);
-        save_solution_details(pb->sol, cfg);
-        if (first) {
-          first = 0;
-          results = add_result(pb);
-          tail = results;
-        } else {
-          tail->next = add_result(pb);
-          tail = tail->next;
-        }
-        free_problem(pb);
-      }
+      results = solve_files(files, cfg);
       print_results(results, cfg);
     } else {
       fprintf(stderr, "No input files given.\n");
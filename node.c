@@ -1,28 +1,26 @@
 #include <stdio.h>
-#include "wrappers.h"
 #include "node.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Public Functions                                                          //
 ///////////////////////////////////////////////////////////////////////////////
 
-//! Return pointer to a clone of the given node.
-Node* clone_node(Node* node) {
-  Node* clone = (Node*) s_malloc(sizeof(Node));
-  clone->id = node->id;
-  clone->x = node->x;
-  clone->y = node->y;
-  clone->demand = node->demand;
-  clone->est = node->est;
-  clone->lst = node->lst;
-  clone->aest = node->aest;
-  clone->alst = node->alst;
-  clone->service_time = node->service_time;
-  clone->prev = (Node *) NULL;  // the clone must not point to the original list
-  clone->next = (Node *) NULL;
-  clone->aest_cache = -1.0;
-  clone->alst_cache = -1.0;
-  return clone;
+//! Copy the given node's data to dst.
+//! The copy is not linked to any other node.
+void copy_node(Node* dst, const Node* src) {
+  dst->id = src->id;
+  dst->x = src->x;
+  dst->y = src->y;
+  dst->demand = src->demand;
+  dst->est = src->est;
+  dst->lst = src->lst;
+  dst->aest = src->aest;
+  dst->alst = src->alst;
+  dst->service_time = src->service_time;
+  dst->prev = (Node *) NULL;  // the copy must not point to the original list
+  dst->next = (Node *) NULL;
+  dst->aest_cache = -1.0;
+  dst->alst_cache = -1.0;
 }
 
 
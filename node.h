@@ -8,9 +8,9 @@
 #ifndef NODE_H
 #define NODE_H
 
-#include "common.h"
+#include <stdbool.h>
 
-typedef struct supernode Supernode;  // TODO: scheduled for removal
+#include "common.h"
 
 struct node {
   int id;
@@ -28,20 +28,51 @@ struct node {
   Node *next;
 };
 
-// contains two or more nodes; for efficient feasibility tests when adding
-// nodes to a route
-struct supernode {  // TODO: scheduled for removal
-  Node *nodes;  // contains in_x and in_y
-  Node *tail;  // contains out_x and out_y
-  int count;
-  double est;
-  double lst;
-  double cum_time;  // includes all service times and internal travel time
+//! \struct segment
+//! Summary of a sequence of consecutive nodes for a given number of workers.
+//! When the first node is reached at time t <= latest, the last node is
+//! served from max(t, earliest) + duration onwards. Summaries of adjacent
+//! sequences are combined in constant time (see concat_segments); this allows
+//! checking the time windows of a modified route without walking it.
+struct segment {
+  double duration;  //!< Minimal time from the first to the last node's start.
+  double earliest;  //!< Starting the first node earlier only adds waiting.
+  double latest;  //!< Latest start at the first node.
+  double load;  //!< Total demand of the nodes.
+  bool feasible;  //!< False if the nodes' time windows can't all be met.
 };
 
-Node *clone_node(Node *);
+void copy_node(Node* dst, const Node* src);
 void print_node(Node *);
 
+//! Return the summary of the given node on its own.
+static inline Segment node_segment(const Node* n) {
+  Segment s;
+  s.duration = 0.0;
+  s.earliest = n->est;
+  s.latest = n->lst;
+  s.load = n->demand;
+  s.feasible = true;
+  return s;
+}
+
+
+//! Return the summary of the sequence a followed by the sequence b.
+//! \param cost The time from a's last to b's first node (including the
+//! service at a's last node).
+static inline Segment concat_segments(Segment a, double cost, Segment b) {
+  double delta = a.duration + cost;
+  double wait = max(b.earliest - delta - a.latest, 0.0);
+  Segment s;
+  s.duration = delta + b.duration + wait;
+  s.earliest = max(b.earliest - delta, a.earliest) - wait;
+  s.latest = min(b.latest - delta, a.latest);
+  s.load = a.load + b.load;
+  s.feasible = a.feasible && b.feasible && a.earliest + delta <= b.latest;
+  return s;
+}
+
+
 static inline double sum_demands(Node* first, Node* last) {
   double demand = first->demand;
   while (first != last) {
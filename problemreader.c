@@ -13,6 +13,7 @@
 #include <time.h>
 
 #include "config.h"
+#include "local_search.h"
 #include "node.h"
 #include "stats.h"
 #include "solution.h"
@@ -27,29 +28,35 @@ static const int CAPACITY_LINE = 5;
 ///////////////////////////////////////////////////////////////////////////////
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
-static void adapt_service_times(int num, Node **nodes, double **d,
-                                Config *cfg_ptr);
+static void adapt_service_times(int num, Node **nodes, const double *d,
+                                size_t stride, Config *cfg_ptr);
 static int get_node_count(FILE *fp);
 static Node **get_nodes(size_t num, FILE *);
-static double ***get_cost_matrix(int num, Node **nodes, Config *cfg_ptr);
+static uint64_t *get_compatibility(Instance *inst);
+static double *get_cost_matrix(Instance *inst);
+static void get_neighbours(Instance *inst);
+static double *get_service_times(Instance *inst);
 static unsigned int get_truck_capacity(FILE *fp);
 
 
 //! Adapt the service times according to Reimann et al. 2011.
-static void adapt_service_times(int num, Node** nodes, double** d, Config*
-cfg_ptr) {
+//! \param d The distance matrix stored with the given row stride.
+static void adapt_service_times(int num, Node** nodes, const double* d,
+                                size_t stride, Config* cfg_ptr) {
   double service_rate = cfg_ptr->service_rate;
   double truck_velocity = cfg_ptr->truck_velocity;
+  size_t depot = (size_t) nodes[0]->id;
 
   if (!cfg_ptr->adapt_service_times)
     return;
   for (int i = 1; i < num; ++i) {
+    size_t id = (size_t) nodes[i]->id;
     nodes[i]->service_time = fmin(service_rate * nodes[i]->demand,
                                   nodes[0]->lst -
                                   max(nodes[i]->est,
-                                       d[nodes[0]->id][nodes[i]->id] /
+                                       d[depot * stride + id] /
                                        truck_velocity) -
-                                  d[nodes[i]->id][nodes[0]->id] /
+                                  d[id * stride + depot] /
                                   truck_velocity);
   }
 }
@@ -139,53 +146,178 @@ static Node** get_nodes(size_t num, FILE* fp) {
 }
 
 
-//! Return array of cost matrices.
-//! Each of the matrices is calculated from the node's data.
+//! Return a contiguous block of cost matrices and set the problem's stride.
+//! Each of the matrices is calculated from the node's data. All matrices
+//! share one cache line aligned allocation; each row is padded to a multiple
+//! of the cache line size to keep the rows aligned as well.
+//! If the costs are configured to be lazy, only the distance matrix is
+//! calculated (see get_service_times).
 //! \return [0] is the distance matrix.
 //!         [1-...] are matrices of the distance plus the required service time
 //!         in the source node given [1-...] workers.
-static double ***get_cost_matrix(int num, Node **nodes, Config *cfg_ptr) {
-  int workers = 0;
-  int max_workers = (int) cfg_ptr->max_workers;
+static double *get_cost_matrix(Instance *inst) {
+  int num = inst->num_nodes;
+  int max_workers = inst->cfg->lazy_costs ? 0 : (int) inst->cfg->max_workers;
+  Node **nodes = inst->nodes;
+  size_t per_line = CACHE_LINE / sizeof(double);
+  size_t stride = ((size_t) num + per_line - 1) / per_line * per_line;
+  size_t size = stride * (size_t) num;  // elements per matrix
   double delta_x = 0.0;
   double delta_y = 0.0;
-  double ***c_m = (double***) s_malloc((size_t) (1 + max_workers) *
-  sizeof(double**));
-  for (int i = 0; i <= max_workers; i++) {
-    c_m[i] = (double**) s_malloc((size_t) num * sizeof(double*));
-    for (int j = 0; j < num; j++) {
-      c_m[i][j] = (double*) s_malloc((size_t) num * sizeof(double));
-    }
-  }
+  double *c_m = (double*) s_aligned_malloc(CACHE_LINE, (size_t) (1 +
+  max_workers) * size * sizeof(double));
   for (int i = 0; i < num; i++) {
+    double *row = c_m + (size_t) i * stride;
     for (int j = 0; j < num; j++) {
       if (i == j) {
-        c_m[0][i][j] = 0.0;
+        row[j] = 0.0;
         continue;
       }
       delta_x = (nodes[i]->x - nodes[j]->x) * (nodes[i]->x - nodes[j]->x);
       delta_y = (nodes[i]->y - nodes[j]->y) * (nodes[i]->y - nodes[j]->y);
-      c_m[0][i][j] = sqrt(delta_x + delta_y);
+      row[j] = sqrt(delta_x + delta_y);
+    }
+    for (size_t j = (size_t) num; j < stride; j++) {
+      row[j] = 0.0;  // padding
     }
   }
-  adapt_service_times(num, nodes, c_m[0], cfg_ptr);
+  adapt_service_times(num, nodes, c_m, stride, inst->cfg);
   // add additional matrices for the total time (including service time)
-  for (workers = 1; workers <= max_workers; workers++) {
+  for (int workers = 1; workers <= max_workers; workers++) {
+    double *matrix = c_m + (size_t) workers * size;
     for (int i = 0; i < num; i++) {
+      const double *d = c_m + (size_t) i * stride;
+      double *row = matrix + (size_t) i * stride;
       for (int j = 0; j < num; j++) {
         if (i == j) {
-          c_m[workers][i][j] = 0.0; // irrel. => ignore service time
+          row[j] = 0.0; // irrel. => ignore service time
           continue;
         }
-        c_m[workers][i][j] = c_m[0][i][j] +
-        nodes[i]->service_time / (double) workers;
+        row[j] = d[j] + nodes[i]->service_time / (double) workers;
+      }
+      for (size_t j = (size_t) num; j < stride; j++) {
+        row[j] = 0.0;  // padding
       }
     }
   }
+  inst->c_m_stride = stride;
   return c_m;
 }
 
 
+//! Return true if a vehicle can serve i and j consecutively in either order.
+//! The fastest service (max_workers) is assumed.
+static bool are_compatible(const Instance *inst, int i, int j) {
+  int workers = (int) inst->cfg->max_workers;
+  return inst_can_follow(inst, workers, i, j) ||
+         inst_can_follow(inst, workers, j, i);
+}
+
+
+//! Return the time window compatibility bit matrices for [0 .. max_workers]
+//! workers and set the instance's bit_words.
+//! j may follow i unless the earliest arrival at j is after j's lst or the
+//! latest departure from i is before i's est. Both tests are evaluated as in
+//! the insertion feasibility checks; as the actual starting times are within
+//! the time windows, a cleared bit implies that these checks fail.
+//! The matrices must be created after the costs.
+static uint64_t *get_compatibility(Instance *inst) {
+  int num = inst->num_nodes;
+  int max_workers = (int) inst->cfg->max_workers;
+  size_t words = ((size_t) num + 63) / 64;
+  size_t size = (size_t) (1 + max_workers) * (size_t) num * words;
+  uint64_t *compatible = (uint64_t*) s_malloc(size * sizeof(uint64_t));
+  memset(compatible, 0, size * sizeof(uint64_t));
+  for (int workers = 0; workers <= max_workers; workers++) {
+    for (int i = 0; i < num; i++) {
+      uint64_t *row = compatible + ((size_t) workers * (size_t) num +
+                      (size_t) i) * words;
+      const Node *n = inst->nodes[i];
+      for (int j = 0; j < num; j++) {
+        double cost = inst_cost(inst, workers, i, j);
+        if ((n->est + cost <= inst->nodes[j]->lst) &&
+            (inst->nodes[j]->lst - cost >= n->est))
+          row[(size_t) j / 64] |= UINT64_C(1) << ((size_t) j % 64);
+      }
+    }
+  }
+  inst->bit_words = words;
+  return compatible;
+}
+
+
+//! Set up the instance's granular neighbour lists.
+//! Requires the time window compatibility matrices.
+//! Each node's neighbours are the (at most) cfg->neighbours nearest customers
+//! that are compatible with the node's time window. The neighbour relation is
+//! stored as list and as bit matrix; the depot is a neighbour of all nodes.
+//! Nothing is allocated if the neighbourhoods are unrestricted.
+static void get_neighbours(Instance *inst) {
+  inst->neighbours = (int*) NULL;
+  inst->num_neighbours = 0;
+  inst->neighbour_bits = (uint64_t*) NULL;
+  if (inst->cfg->neighbours == UNLIMITED)
+    return;
+  int num = inst->num_nodes;
+  int k = (int) inst->cfg->neighbours;
+  if (k > num - 1)
+    k = num - 1;
+  size_t words = inst->bit_words;
+  int *neighbours = (int*) s_malloc((size_t) num * (size_t) k * sizeof(int));
+  uint64_t *bits = (uint64_t*) s_malloc((size_t) num * words *
+                                        sizeof(uint64_t));
+  memset(bits, 0, (size_t) num * words * sizeof(uint64_t));
+  for (int i = 0; i < num; i++) {
+    int *list = neighbours + (size_t) i * (size_t) k;
+    uint64_t *row = bits + (size_t) i * words;
+    const double *d = inst_dist_row(inst, i);
+    int len = 0;
+    for (int j = 1; j < num; j++) {  // insertion into the sorted k nearest
+      if (j == i || !are_compatible(inst, i, j))
+        continue;
+      if (len == k && d[j] >= d[list[k - 1]])
+        continue;
+      int pos = (len < k) ? len++ : k - 1;
+      for (; pos > 0 && d[list[pos - 1]] > d[j]; pos--)
+        list[pos] = list[pos - 1];
+      list[pos] = j;
+    }
+    for (int l = len; l < k; l++)
+      list[l] = DEPOT;  // less than k compatible customers
+    for (int l = 0; l < k; l++)
+      row[(size_t) list[l] / 64] |= UINT64_C(1) << ((size_t) list[l] % 64);
+    row[DEPOT / 64] |= UINT64_C(1) << (DEPOT % 64);
+  }
+  inst->neighbours = neighbours;
+  inst->num_neighbours = k;
+  inst->neighbour_bits = bits;
+}
+
+
+//! Return the service times per node for [0 .. max_workers] workers.
+//! Return NULL unless the costs are configured to be lazy. This table replaces
+//! all but the first cost matrix. It must be created after the cost matrix as
+//! it depends on the adapted service times.
+static double *get_service_times(Instance *inst) {
+  if (!inst->cfg->lazy_costs)
+    return (double*) NULL;
+  size_t num = (size_t) inst->num_nodes;
+  int max_workers = (int) inst->cfg->max_workers;
+  double *service = (double*) s_aligned_malloc(CACHE_LINE, (size_t) (1 +
+  max_workers) * num * sizeof(double));
+  for (size_t i = 0; i < num; i++) {
+    service[i] = 0.0;  // no workers => distances only
+  }
+  for (int workers = 1; workers <= max_workers; workers++) {
+    for (size_t i = 0; i < num; i++) {
+      service[(size_t) workers * num + i] = inst->nodes[i]->service_time /
+                                            (double) workers;
+    }
+  }
+  return service;
+}
+
+
 //! Return the truck's capacity.
 static unsigned int get_truck_capacity(FILE* fp) {
   rewind(fp);
@@ -209,25 +341,61 @@ static unsigned int get_truck_capacity(FILE* fp) {
 // Public Functions                                                          //
 ///////////////////////////////////////////////////////////////////////////////
 
+//! Free the memory of the given instance.
+//! Do not free the config as it may be used by other instances.
+void free_instance(Instance* inst) {
+  free(inst->nodes[0]);
+  free(inst->nodes);
+  free(inst->c_m);
+  free(inst->service);
+  free(inst->neighbours);
+  free(inst->neighbour_bits);
+  free(inst->compatible);
+  free(inst->name);
+  free(inst);
+}
+
+
 //! Free the memory of the given VRPTWMS.
+//! The instance is only freed if it is owned by the problem (see get_problem).
 //! Do not free the config as it may be used by other problem instances.
 //! The config has to be freed separately.
 void free_problem(Problem* pb) {
-  free(pb->nodes[0]);
-  free(pb->nodes);
-  for (int i = 0; i <= pb->cfg->max_workers; ++i) {
-    free_double_matrix(pb->c_m[i], (size_t) pb->num_nodes);
-  }
-  free(pb->c_m);
-  free(pb->name);
+  size_t num = (size_t) pb->inst->num_nodes;
   free_solution(pb->sol);
-  free_double_matrix(pb->pheromone, (size_t) (2 * pb->num_nodes - 1));
-  free_stats(pb->stats, (size_t) pb->num_nodes);
-  free_tabulist(pb->tl, (size_t) pb->num_nodes);
+  free_move_evaluator(pb->evaluator);
+  free_double_matrix(pb->pheromone, 2 * num - 1);
+  free_stats(pb->stats, num);
+  free_tabulist(pb->tl, num);
+  if (pb->owns_inst)
+    free_instance((Instance*) pb->inst);
   free(pb);
 }
 
 
+//! Read the instance stored in the given file.
+//! \return the instance or NULL if the file is not readable
+Instance* get_instance(const char* fname, Config* cfg) {
+  FILE *fp = fopen(fname, "r");
+  if (!fp) {
+    fprintf(stderr, "input file \"%s\" is ignored (not readable)\n", fname);
+    return NULL;
+  }
+  Instance* inst = (Instance*) s_malloc(sizeof(Instance));
+  inst->num_nodes = get_node_count(fp);
+  inst->cfg = cfg;
+  inst->nodes = get_nodes((size_t) inst->num_nodes, fp);
+  inst->c_m = get_cost_matrix(inst);
+  inst->service = get_service_times(inst);
+  inst->compatible = get_compatibility(inst);
+  get_neighbours(inst);
+  inst->capacity = get_truck_capacity(fp);
+  inst->name = get_name(fname);
+  fclose(fp);
+  return inst;
+}
+
+
 //! Return the problem's name (the problem's filename without its extension).
 char* get_name(const char* fname) {
   char* name;
@@ -242,52 +410,72 @@ char* get_name(const char* fname) {
 }
 
 
-//! Allocate memory for a problem instance and return a pointer to it.
+//! Read the instance stored in the given file and return a new problem.
+//! The problem owns the instance; it is freed along with the problem.
 Problem* get_problem(const char* fname, Config* cfg) {
-  FILE *fp = fopen(fname, "r");
-  if (!fp) {
-    fprintf(stderr, "input file \"%s\" is ignored (not readable)\n", fname);
+  Instance* inst = get_instance(fname, cfg);
+  if (!inst)
     return NULL;
-  }
+  Problem* pb = new_problem(inst);
+  pb->owns_inst = true;
+  return pb;
+}
+
+
+//! Allocate memory for a new search for solutions to the given instance.
+//! The instance is shared and must outlive the problem. Any number of
+//! problems may concurrently use the same instance.
+Problem* new_problem(const Instance* inst) {
+  Config* cfg = inst->cfg;
+  size_t num = (size_t) inst->num_nodes;
   Problem* pb = (Problem*) s_malloc(sizeof(Problem));
-  pb->num_nodes = get_node_count(fp);
+  pb->inst = inst;
+  pb->owns_inst = false;
   pb->cfg = cfg;
-  if (pb->cfg->ants_dynamic) pb->cfg->ants = pb->num_nodes - 1;
-  pb->nodes = get_nodes((size_t) pb->num_nodes, fp);
-  pb->c_m = get_cost_matrix(pb->num_nodes, pb->nodes, cfg);
-  pb->capacity = get_truck_capacity(fp);
+  pb->ants = cfg->ants_dynamic ? inst->num_nodes - 1 : cfg->ants;
   pb->num_solutions = 0;
-  pb->name = get_name(fname);
   pb->start_time = time((time_t*) NULL);
+  seed_rng(&pb->rng, (unsigned long) cfg->seed);
+  pb->evaluator = new_move_evaluator(pb);
   pb->sol = new_solution(pb);
-  pb->pheromone = init_double_matrix((size_t) ((2 * pb->num_nodes) - 1),
-                                     cfg->initial_pheromone);
+  pb->pheromone = init_double_matrix(2 * num - 1, cfg->initial_pheromone);
+  pb->pheromone_scale = 1.0;
+  pb->pheromone_floor = 0.0;
   pb->state = REDUCE_TRUCKS;
   pb->attempts = 0;
   pb->tl = new_tabulist(pb);
-  fclose(fp);
-  pb->stats = init_stats((size_t) pb->num_nodes);
+  pb->stats = init_stats(num);
   return pb;
 }
 
 
-//! Return pointer to a clone of the depot.
-Node* new_depot(Problem *pb) {
-  return clone_node(pb->nodes[DEPOT]);
-}
-
-
 //! Print the problem to stdout.
 void print_problem(Problem *pb) {
   if (!pb) return;
+  const Instance* inst = pb->inst;
   int i = 0;
-  printf ("problem: %s\n", pb->name);
-  printf ("truck capacity: %u\n", pb->capacity);
-  printf ("%d nodes (including the depot)\n", pb->num_nodes);
-  for (i = 0; i < pb->num_nodes; ++i) {
-    print_node(pb->nodes[i]);
+  printf ("problem: %s\n", inst->name);
+  printf ("truck capacity: %u\n", inst->capacity);
+  printf ("%d nodes (including the depot)\n", inst->num_nodes);
+  for (i = 0; i < inst->num_nodes; ++i) {
+    print_node(inst->nodes[i]);
   }
   printf("\n");
-  print_double_matrix(pb->num_nodes, pb->c_m[0], "cost matrix");
+  print_flat_double_matrix(inst->num_nodes, inst->c_m, inst->c_m_stride,
+                           "cost matrix");
+}
+
+
+//! Set the pheromone on all arcs to the given value.
+//! The first row and column are ignored throughout the program.
+void set_pheromone(Problem* pb, double value) {
+  int dim = 2 * pb->inst->num_nodes - 1;
+  for (int i = 1; i < dim; ++i) {  // ignore 0 DEPOT
+    for (int j = 1; j < dim; ++j) {
+      pb->pheromone[i][j] = value;
+    }
+  }
+  pb->pheromone_scale = 1.0;
+  pb->pheromone_floor = 0.0;  // min_pheromone only applies after evaporation
 }
 
@@ -8,10 +8,13 @@
 #ifndef PROBLEMREADER_H
 #define PROBLEMREADER_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <time.h>
 
 #include "common.h"
+#include "rng.h"
 
 enum problem_state {
   REDUCE_TRUCKS,
@@ -19,18 +22,53 @@ enum problem_state {
   REDUCE_DISTANCE
 };
 
-struct problem {
-  long int attempts;  // remaining reduction attempts in the current state
+//! The immutable data of a VRPTWMS instance.
+//! An instance is never modified once it is read. Hence, any number of
+//! problems (search contexts) can share it, including concurrent ones.
+struct instance {
   unsigned int capacity;  //!< the truck's capacity
-  Config* cfg;
-  //! Array of cost matrices.
-  //! [0] for distances, [n] includes servicetime for n workers
-  double*** c_m;
-  long num_solutions;  //!< counts the total iterations
+  Config* cfg;  //!< The configuration the derived data was calculated for.
+  //! Contiguous, cache line aligned block of (1 + max_workers) cost matrices.
+  //! [0] for distances, [n] includes servicetime for n workers.
+  //! If the costs are lazy, the block only contains the distance matrix.
+  //! Use get_cost and get_dist instead of indexing the block directly.
+  double* c_m;
+  size_t c_m_stride;  //!< Row stride of the cost matrices (in doubles).
+  //! Service time per node for [0 .. max_workers] workers ([0] is all zeros).
+  //! Only used (not NULL) if the service times are added lazily.
+  double* service;
   char* name;  //!< the input file's name without its extension
   Node** nodes;  //!< array of Node* including the depot
   int num_nodes;  //!< number of nodes including the depot
-  double** pheromone;  //!< pheromone matrix, initialized to [1 .. 1]
+  //! Granular neighbour lists; num_neighbours ids per node sorted by distance.
+  //! Only the nearest nodes with compatible time windows are neighbours.
+  //! NULL if the neighbourhoods are not restricted (see is_neighbour).
+  int* neighbours;
+  int num_neighbours;  //!< Neighbours per node; 0 if not restricted.
+  //! Bit matrix of the neighbour relation; the depot neighbours every node.
+  uint64_t* neighbour_bits;
+  //! Bit matrices (one per number of workers [0 .. max_workers]) with bit j
+  //! of row i set if j can be served directly after i (see can_follow).
+  uint64_t* compatible;
+  size_t bit_words;  //!< Words per row of the bit matrices.
+};
+
+//! The mutable state of a search for solutions to an instance.
+struct problem {
+  const Instance* inst;  //!< The (possibly shared) instance data.
+  bool owns_inst;  //!< If true, the instance is freed with the problem.
+  long int ants;  //!< Ants per generation (cfg->ants or the # of customers).
+  long int attempts;  // remaining reduction attempts in the current state
+  Config* cfg;
+  long num_solutions;  //!< counts the total iterations
+  //! Stored pheromone values; use get_pheromone for reading them.
+  //! Evaporation is applied lazily: the actual value is the stored value
+  //! times pheromone_scale, but at least pheromone_floor.
+  double** pheromone;
+  double pheromone_scale;  //!< Evaporation not yet applied to the values.
+  double pheromone_floor;  //!< min_pheromone once the pheromone evaporated.
+  Rng rng;  //!< The solver's random number generator (seeded with cfg->seed).
+  Move_Evaluator* evaluator;  //!< The solver's evaluator for the best moves.
   Solution* sol;  //!< pointer to the currently best solution
   time_t start_time;
   enum problem_state state;
@@ -38,10 +76,101 @@ struct problem {
   Stats* stats;  //!< For collecting statistical data for TS.
 };
 
+void free_instance(Instance*);
 void free_problem(Problem*);
+Instance* get_instance(const char* fname, Config* cfg);
 char* get_name(const char* fname);
 Problem *get_problem(const char* fname, Config* cfg_ptr);
-Node *new_depot(Problem*);
+Problem* new_problem(const Instance* inst);
 void print_problem(Problem*);
+void set_pheromone(Problem*, double value);
+
+
+//! Return the distance matrix' row of node i.
+static inline const double* inst_dist_row(const Instance* inst, int i) {
+  return inst->c_m + (size_t) i * inst->c_m_stride;
+}
+
+
+//! Return the distance between nodes i and j.
+static inline double inst_dist(const Instance* inst, int i, int j) {
+  return inst->c_m[(size_t) i * inst->c_m_stride + (size_t) j];
+}
+
+
+//! Return true if j is one of i's granular neighbours.
+//! If the neighbourhoods are not restricted, every node is a neighbour.
+static inline bool inst_is_neighbour(const Instance* inst, int i, int j) {
+  if (!inst->neighbour_bits)
+    return true;
+  const uint64_t* row = inst->neighbour_bits + (size_t) i * inst->bit_words;
+  return (row[(size_t) j / 64] >> ((size_t) j % 64)) & 1u;
+}
+
+
+//! Return true if the time windows allow serving j directly after i.
+//! If this returns false, no route with the given number of workers can
+//! ever contain the arc from i to j. The reverse is not guaranteed.
+static inline bool inst_can_follow(const Instance* inst, int workers, int i,
+                                   int j) {
+  const uint64_t* row = inst->compatible + ((size_t) workers *
+                        (size_t) inst->num_nodes + (size_t) i) *
+                        inst->bit_words;
+  return (row[(size_t) j / 64] >> ((size_t) j % 64)) & 1u;
+}
+
+
+//! Return the travel time from i to j plus the service time at i.
+//! The service time depends on the number of workers; 0 workers return the
+//! distance. With lazy costs, i == j does not yield 0 for customers; this
+//! never matters as a node can't be its own neighbour (the depot has no
+//! service time).
+static inline double inst_cost(const Instance* inst, int workers, int i,
+                               int j) {
+  if (inst->service)
+    return inst_dist(inst, i, j) + inst->service[(size_t) workers *
+                                                 (size_t) inst->num_nodes +
+                                                 (size_t) i];
+  return inst->c_m[((size_t) workers * (size_t) inst->num_nodes +
+                    (size_t) i) * inst->c_m_stride + (size_t) j];
+}
+
+
+//! Return the distance matrix' row of node i.
+static inline const double* get_dist_row(const Problem* pb, int i) {
+  return inst_dist_row(pb->inst, i);
+}
+
+
+//! Return the distance between nodes i and j.
+static inline double get_dist(const Problem* pb, int i, int j) {
+  return inst_dist(pb->inst, i, j);
+}
+
+
+//! Return true if j is one of i's granular neighbours (see inst_is_neighbour).
+static inline bool is_neighbour(const Problem* pb, int i, int j) {
+  return inst_is_neighbour(pb->inst, i, j);
+}
+
+
+//! Return true if the time windows allow serving j directly after i
+//! (see inst_can_follow).
+static inline bool can_follow(const Problem* pb, int workers, int i, int j) {
+  return inst_can_follow(pb->inst, workers, i, j);
+}
+
+
+//! Return the pheromone on the arc from i to j.
+static inline double get_pheromone(const Problem* pb, int i, int j) {
+  return max(pb->pheromone[i][j] * pb->pheromone_scale, pb->pheromone_floor);
+}
+
+
+//! Return the travel time from i to j plus the service time at i
+//! (see inst_cost).
+static inline double get_cost(const Problem* pb, int workers, int i, int j) {
+  return inst_cost(pb->inst, workers, i, j);
+}
 
 #endif
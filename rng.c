@@ -0,0 +1,57 @@
+/** \file
+ *
+ * \author Gerald Senarclens de Grancy <oss@senarclens.eu>
+ * \copyright GNU General Public License version 3
+ *
+ */
+
+#include "rng.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File Scope (Static) Functions                                             //
+///////////////////////////////////////////////////////////////////////////////
+
+//! Advance the given splitmix64 state and return its next output.
+//! Used to expand a single seed into a generator's state.
+static uint64_t next_splitmix(uint64_t* x) {
+  uint64_t z = (*x += UINT64_C(0x9E3779B97F4A7C15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return z ^ (z >> 31);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Functions                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+//! Advance the generator by 2^128 draws.
+//! Calling this repeatedly on a copy of a generator yields streams that
+//! don't overlap with each other or with the original generator.
+void jump_rng(Rng* rng) {
+  static const uint64_t JUMP[] = {
+    UINT64_C(0x180EC6D33CFD0ABA), UINT64_C(0xD5A61266F0C9392C),
+    UINT64_C(0xA9582618E03FC9AA), UINT64_C(0x39ABDC4529B1661C)
+  };
+  uint64_t s[4] = {0, 0, 0, 0};
+  for (int i = 0; i < 4; ++i) {
+    for (int b = 0; b < 64; ++b) {
+      if (JUMP[i] & UINT64_C(1) << b) {
+        for (int j = 0; j < 4; ++j)
+          s[j] ^= rng->s[j];
+      }
+      next_rng(rng);
+    }
+  }
+  for (int j = 0; j < 4; ++j)
+    rng->s[j] = s[j];
+}
+
+
+//! Initialize the generator's state from the given seed.
+void seed_rng(Rng* rng, unsigned long seed) {
+  uint64_t x = seed;
+  for (int i = 0; i < 4; ++i)
+    rng->s[i] = next_splitmix(&x);
+}
@@ -0,0 +1,62 @@
+/** \file
+ *
+ * \author Gerald Senarclens de Grancy <oss@senarclens.eu>
+ * \copyright GNU General Public License version 3
+ *
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+//! State of a xoshiro256** pseudo random number generator.
+//! See David Blackman and Sebastiano Vigna, "Scrambled Linear Pseudorandom
+//! Number Generators", ACM Transactions on Mathematical Software, Vol. 47,
+//! No. 4, 2021.
+//! Each generator is independent; generators that are used concurrently must
+//! not be shared between threads. Use jump_rng to derive non-overlapping
+//! streams.
+struct rng {
+  uint64_t s[4];
+};
+
+void jump_rng(Rng*);
+void seed_rng(Rng*, unsigned long seed);
+
+
+//! Return x rotated left by k bits.
+static inline uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+
+//! Advance the generator and return the next 64 random bits.
+static inline uint64_t next_rng(Rng* rng) {
+  uint64_t* s = rng->s;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+
+//! Return a non-negative long uniformly distributed over [0, 2^63).
+static inline long rand_long(Rng* rng) {
+  return (long) (next_rng(rng) >> 1);
+}
+
+
+//! Return a double uniformly distributed over [0.0, 1.0).
+static inline double rand_uniform(Rng* rng) {
+  return (double) (next_rng(rng) >> 11) * (1.0 / 9007199254740992.0);  // 2^53
+}
+
+#endif
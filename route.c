@@ -5,14 +5,15 @@
  *
  */
 
-#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "config.h"
 #include "node.h"
 #include "problemreader.h"
+#include "rng.h"
 #include "solution.h"
 #include "vrptwms.h"
 #include "wrappers.h"
@@ -21,15 +22,85 @@
 ///////////////////////////////////////////////////////////////////////////////
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
-static void free_insertions(Insertion* insertions);
-
-//! Free the memory of the given insertions.
-static void free_insertions(Insertion* insertions) {
-  while (insertions) {
-    Insertion* temp = insertions->next;
-    free(insertions);
-    insertions = temp;
+static const int MIN_ARRAY_CAPACITY = 16;  // entries per new route array
+
+static void fill_entries(Route_Array* a, int pos, Node* first, int count);
+static void init_route_array(Route_Array* a, int capacity, int max_workers);
+static void move_entries(Route_Array* dst, int to, const Route_Array* src,
+                         int from, int count);
+static void reserve_entries(Route* route, int len);
+
+
+//! Copy count nodes starting with first into the arrays (from pos onwards).
+static void fill_entries(Route_Array* a, int pos, Node* first, int count) {
+  for (int i = pos; i < pos + count; ++i) {
+    a->aest[i] = first->aest;
+    a->alst[i] = first->alst;
+    a->est[i] = first->est;
+    a->lst[i] = first->lst;
+    a->demand[i] = first->demand;
+    a->nodes[i] = first;
+    a->ids[i] = first->id;
+    first = first->next;
   }
+  a->min_workers = 0;
+  a->segments_valid = false;
+}
+
+
+//! Allocate the arrays of a route array in a single block.
+//! \param max_workers The number of worker counts to summarize segments for.
+static void init_route_array(Route_Array* a, int capacity, int max_workers) {
+  size_t cap = (size_t) capacity;
+  size_t segments = cap * (size_t) max_workers;
+  char* block = (char*) s_malloc(cap * (5 * sizeof(double) + sizeof(Node*) +
+                                        sizeof(int)) +
+                                 2 * segments * sizeof(Segment));
+  a->aest = (double*) block;
+  a->alst = a->aest + cap;
+  a->est = a->alst + cap;
+  a->lst = a->est + cap;
+  a->demand = a->lst + cap;
+  a->fwd = (Segment*) (a->demand + cap);
+  a->bwd = a->fwd + segments;
+  a->nodes = (Node**) (a->bwd + segments);
+  a->ids = (int*) (a->nodes + cap);
+  a->capacity = capacity;
+  a->max_workers = max_workers;
+  a->min_workers = 0;
+  a->segments_valid = false;
+}
+
+
+//! Move count entries of src starting at from to dst starting at to.
+//! The source and destination ranges may overlap.
+static void move_entries(Route_Array* dst, int to, const Route_Array* src,
+                         int from, int count) {
+  dst->min_workers = 0;
+  dst->segments_valid = false;
+  if (count <= 0) return;
+  size_t n = (size_t) count;
+  memmove(dst->aest + to, src->aest + from, n * sizeof(double));
+  memmove(dst->alst + to, src->alst + from, n * sizeof(double));
+  memmove(dst->est + to, src->est + from, n * sizeof(double));
+  memmove(dst->lst + to, src->lst + from, n * sizeof(double));
+  memmove(dst->demand + to, src->demand + from, n * sizeof(double));
+  memmove(dst->nodes + to, src->nodes + from, n * sizeof(Node*));
+  memmove(dst->ids + to, src->ids + from, n * sizeof(int));
+}
+
+
+//! Make sure the route's arrays can hold at least len entries.
+static void reserve_entries(Route* route, int len) {
+  if (len <= route->arr.capacity) return;
+  int capacity = route->arr.capacity;
+  while (capacity < len)
+    capacity *= 2;
+  Route_Array grown;
+  init_route_array(&grown, capacity, route->arr.max_workers);
+  move_entries(&grown, 0, &route->arr, 0, route->len);
+  free(route->arr.aest);  // the start of the block
+  route->arr = grown;
 }
 
 
@@ -39,23 +110,28 @@ static void free_insertions(Insertion* insertions) {
 
 //! "Constructor".
 //! Once constructed, the route is added to the solution and the number of
-//! trucks incremented.
+//! trucks incremented. The route and its depots are taken from the
+//! solution's storage (see acquire_route).
 Route* new_route(Solution* sol, Node* seed, int workers) {
-  Route* route = (Route*) s_malloc(sizeof(Route));
+  Route* route = acquire_route(sol);
   route->pb = sol->pb;
-  route->depot_id = route->pb->num_nodes + sol->trucks;
+  route->depot_id = route->pb->inst->num_nodes + sol->trucks;
   route->id = sol->trucks;
   sol->routes[sol->trucks] = route;
   sol->trucks++;
-  route->nodes = new_depot(route->pb);
   route->nodes->next = seed;
   seed->prev = route->nodes;
-  seed->next = new_depot(route->pb);
-  route->tail = seed->next;
+  seed->next = route->tail;
   route->tail->prev = seed;
   route->len = ONE_CUSTOMER;  // includes the opening and closing depot
   route->load = seed->demand;
   route->workers = workers;
+  route->dirty = true;
+  route->hash = arc_key(DEPOT, seed->id) ^ arc_key(seed->id, DEPOT);
+  if (!route->arr.capacity)  // the arrays are kept when a route is released
+    init_route_array(&route->arr, MIN_ARRAY_CAPACITY,
+                     (int) route->pb->cfg->max_workers);
+  fill_entries(&route->arr, 0, route->nodes, ONE_CUSTOMER);
   calc_ests(route, route->nodes, workers);
   calc_lsts(route, route->tail, workers);
   return route;
@@ -78,12 +154,26 @@ void add_nodes(Route* r, Node* first, Node* last, Node* after) {
 //! Do not update the ests and lsts.
 //! The added nodes are have to be removed from other routes before!
 inline void add_nodes_noupdate(Route* r, Node* first, Node* last, Node* after) {
+  journal_route(r);
+  int pos = get_position(r, after) + 1;
+  int count = 0;
   Node* n = first;
+  uint64_t hash = arc_key(after->id, after->next->id) ^
+                  arc_key(after->id, first->id) ^
+                  arc_key(last->id, after->next->id);
   do {
     r->load += n->demand;
-    r->len++;
+    count++;
+    if (n != last)
+      hash ^= arc_key(n->id, n->next->id);
     n = n->next;
   } while (n != last->next);
+  r->hash ^= hash;
+  reserve_entries(r, r->len + count);
+  move_entries(&r->arr, pos + count, &r->arr, pos, r->len - pos);
+  fill_entries(&r->arr, pos, first, count);
+  r->len += count;
+  r->dirty = true;
   first->prev = after;
   last->next = after->next;
   last->next->prev = last;
@@ -104,44 +194,45 @@ inline void add_nodes_noupdate(Route* r, Node* first, Node* last, Node* after) {
 //! \return 1 if a new best insertion was found, otherwise 0
 int calc_best_insertion(Route *route, Node *node, Insertion *ins) {
   int updated = 0;
-  Node *after = route->nodes;
+  const Route_Array *a = &route->arr;
   double cost_dist = 0.0; double cost_time = 0.0; double cost = 0.0;
   double est_node = 0.0; double est_succ = 0.0;
-  double **d = route->pb->c_m[0]; // distance
-  double **c_m = route->pb->c_m[route->workers];
+  const Problem *pb = route->pb;
+  int workers = route->workers;
   double alpha = route->pb->cfg->alpha; double alpha2 = 1.0 - alpha;
   double mu = route->pb->cfg->mu;
   double lambda = route->pb->cfg->lambda;
 
-  if (route->pb->capacity < route->load + node->demand)
+  if (route->pb->inst->capacity < route->load + node->demand)
     return 0;
-  while (after != route->tail) {
-    if (!can_insert_one(route, node, after)) {
-      after = after->next;
+  for (int i = 0; i < route->len - 1; ++i) {  // insert after node i
+    if (!is_granular_position(route, node, i) ||
+        !can_insert_at(route, node, i))
       continue;
-    }
-    cost_dist = d[after->id][node->id] + d[node->id][after->next->id] -
-      mu * d[after->id][after->next->id];
+    int pred = a->ids[i], succ = a->ids[i + 1];
+    cost_dist = get_dist(pb, pred, node->id) +
+      get_dist(pb, node->id, succ) -
+      mu * get_dist(pb, pred, succ);
     if (alpha2) {
-      est_node = max(node->est, after->aest + c_m[after->id][node->id]);
-      est_succ = max(after->next->est,
-                      est_node + c_m[node->id][after->next->id]);
-      cost_time = est_succ - after->next->aest;
+      est_node = max(node->est,
+                     a->aest[i] + get_cost(pb, workers, pred, node->id));
+      est_succ = max(a->est[i + 1],
+                      est_node + get_cost(pb, workers, node->id, succ));
+      cost_time = est_succ - a->aest[i + 1];
     }
     cost = alpha * cost_dist + alpha2 * cost_time;
     // slight deviation from solomon: we minimize the "cost" instead of
     // maximizing the attractiveness, thus "cost - lambda * d_{0n}"
-    cost = cost - lambda * d[0][node->id];
+    cost = cost - lambda * get_dist(pb, DEPOT, node->id);
     if (cost < ins->cost) {
       ins->prev = (Insertion*) NULL;
       ins->next = (Insertion*) NULL;
       ins->target = route;
       ins->node = node;
-      ins->after = after;
+      ins->after = a->nodes[i];
       ins->cost = cost;
       updated = 1;
     }
-    after = after->next;
   }
   return updated;
 }
@@ -157,18 +248,24 @@ void calc_ests(Route *route, Node *n, int workers) {
     exit(EXIT_FAILURE);
   }
   #endif
-  double **c_m = route->pb->c_m[workers];  // includes service time
+  const Problem *pb = route->pb;  // get_cost includes the service time
   if (route->workers == workers) {  // calculate the actual values
-    if (n == route->nodes) {  // if n is the opening depot
-      n->aest = n->est;
-      n = n->next;
+    Route_Array *a = &route->arr;
+    int i = get_position(route, n);
+    if (!i) {  // if n is the opening depot
+      a->aest[0] = a->est[0];
+      a->nodes[0]->aest = a->aest[0];
+      i++;
     }
-    while (n->next) {  //  aest is not relevant for the closing depot
-                       //  as it is not used by insert*feasible
-      n->aest = max(n->est, n->prev->aest + c_m[n->prev->id][n->id]);
-      n = n->next;
+    for (; i < route->len - 1; ++i) {  // aest is not relevant for the closing
+                                       // depot as it is not used by
+                                       // insert*feasible
+      a->aest[i] = max(a->est[i], a->aest[i - 1] +
+                       get_cost(pb, workers, a->ids[i - 1], a->ids[i]));
+      a->nodes[i]->aest = a->aest[i];
     }
-  } else {  // fill the cache
+  } else {  // fill the cache; the list is used as move_reduces_workers
+            // temporarily unlinks nodes
     if (n == route->nodes) {  // if n is the opening depot
       n->aest_cache = n->est;
       n = n->next;
@@ -176,7 +273,7 @@ void calc_ests(Route *route, Node *n, int workers) {
     while (n) {  // aest_cache is relevant for the closing depot as it is
                  // required by is_feasible_with
       n->aest_cache = max(n->est, n->prev->aest_cache +
-        c_m[n->prev->id][n->id]);
+        get_cost(pb, workers, n->prev->id, n->id));
       n = n->next;
     }
   }
@@ -187,14 +284,18 @@ void calc_ests(Route *route, Node *n, int workers) {
 //! \param workers number of workers that is used for calculating the lsts
 //! \param n last node that needs to be updated (update from n to head)
 void calc_lsts(Route *route_ptr, Node *n, int workers) {
-  double **c_m = route_ptr->pb->c_m[workers]; // includes service time
-  if (n == route_ptr->tail) {  // if n is the closing depot
-    n->alst = n->lst;
-    n = n->prev;
+  const Problem *pb = route_ptr->pb;  // get_cost includes the service time
+  Route_Array *a = &route_ptr->arr;
+  int i = get_position(route_ptr, n);
+  if (i == route_ptr->len - 1) {  // if n is the closing depot
+    a->alst[i] = a->lst[i];
+    a->nodes[i]->alst = a->alst[i];
+    i--;
   }
-  while (n->prev) {
-    n->alst = fmin(n->lst, n->next->alst - c_m[n->id][n->next->id]);
-    n = n->prev;
+  for (; i > 0; --i) {  // alst is not relevant for the opening depot
+    a->alst[i] = fmin(a->lst[i], a->alst[i + 1] -
+                      get_cost(pb, workers, a->ids[i], a->ids[i + 1]));
+    a->nodes[i]->alst = a->alst[i];
   }
 }
 
@@ -202,105 +303,157 @@ void calc_lsts(Route *route_ptr, Node *n, int workers) {
 //! Calculate the total distance of the route.
 double calc_length(Route* route) {
   double dist = 0.0;
-  double** c_m = route->pb->c_m[0];
-  Node* n = route->nodes->next; // first customer node
-  while (n) {
-    dist += c_m[n->prev->id][n->id];
-    n = n->next;
+  const Problem* pb = route->pb;
+  const int* ids = route->arr.ids;
+  for (int i = 1; i < route->len; ++i) {
+    dist += get_dist(pb, ids[i - 1], ids[i]);
   }
   return dist;
 }
 
 
-//! Clone a route and return a pointer to the clone.
-//! If a route is cloned, all lists are regenerated to be different
-//! objects.
-Route* clone_route(Route* route) {
-  Node *n = route->nodes;
-  Route *clone = (Route *) s_malloc(sizeof(Route));
-  clone->pb = route->pb;
-  clone->id = route->id;
-  clone->depot_id = route->depot_id;
-  clone->len = route->len;
-  clone->load = route->load;
-  clone->workers = route->workers;
-  clone->nodes = clone_node(n);
-  clone->tail = clone->nodes;
-  n = n->next;
-  while (n) {
-    clone->tail->next = clone_node(n);
-    clone->tail->next->prev = clone->tail;
-    clone->tail = clone->tail->next;
-    n = n->next;
+//! Copy a route of another solution to the route dst.
+//! The nodes are owned by the solutions' node arenas (see solution::arena)
+//! and have to be copied before; only the pointers are rebased here.
+//! \param arena The node arena of dst's solution.
+//! \param src_arena The node arena of src's solution.
+void copy_route(Route* dst, const Route* src, Node* arena,
+                const Node* src_arena) {
+  Route_Array arr = dst->arr;  // keep the destination's storage
+  Solution* sol = dst->sol;
+  *dst = *src;
+  dst->arr = arr;
+  dst->sol = sol;
+  dst->dirty = true;
+  dst->nodes = arena + (src->nodes - src_arena);
+  dst->tail = arena + (src->tail - src_arena);
+  if (dst->arr.capacity < src->len) {
+    free(dst->arr.aest);  // the start of the arrays' block
+    init_route_array(&dst->arr, src->arr.capacity, src->arr.max_workers);
+  }
+  move_entries(&dst->arr, 0, &src->arr, 0, src->len);
+  for (int i = 0; i < src->len; ++i) {
+    dst->arr.nodes[i] = arena + (src->arr.nodes[i] - src_arena);
   }
-  return clone;
+}
+
+
+//! Free the memory of the given insertion list.
+void free_insertion_list(Insertion_List* il) {
+  free(il->items);
+  il->items = (Insertion*) NULL;
+  il->size = 0;
 }
 
 
 //! "Destructor".
-//! Free the memory of the given route and all allocated members.
+//! Free the memory of the given route's arrays. The route itself and its
+//! nodes are owned by the solution.
 void free_route(Route *route) {
-  Node *n = route->nodes->next;
-  while (n) {
-    free(n->prev);
-    n = n->next;
-  }
-  free(route->tail);
-  free(route);
+  free(route->arr.aest);  // the start of the arrays' block
+  route->arr.aest = (double*) NULL;
+  route->arr.capacity = 0;
 }
 
 
-//! Return the best insertion of Node n on Route r.
-//! Memory for the returned insertion is allocated and needs to be freed
-//! by the caller.
-//! If no insertion is feasible, the NULL pointer is returned.
+//! Set ins to the best insertion of Node n on Route r.
 //! The returned insertion structure can be used in doubly linked lists.
-Insertion* get_best_insertion(Route* r, Node* n) {
-  Insertion* ins = (Insertion*) NULL;
-  if (r->pb->capacity < r->load + n->demand) return ins;
+//! \return 1 if there is a feasible insertion, otherwise 0 (ins is undefined).
+int get_best_insertion(Route* r, Node* n, Insertion* ins) {
+  if (r->pb->inst->capacity < r->load + n->demand) return 0;
   double alpha = r->pb->cfg->alpha, alpha2 = 1.0 - alpha;
-  double** c_m = r->pb->c_m[r->workers];
-  double** d = r->pb->c_m[0];  // distance matrix
+  const Problem* pb = r->pb;
+  const Route_Array* a = &r->arr;
+  int workers = r->workers;
   double mu = r->pb->cfg->mu;
   double lambda = r->pb->cfg->lambda;
-  Node* after = r->nodes;
-  while (after != r->tail) {
-    if (!can_insert_one(r, n, after)) {
-      after = after->next;
+  int found = 0;
+  ins->attractiveness = -INFINITY;
+  for (int i = 0; i < r->len - 1; ++i) {  // insert after node i
+    if (!is_granular_position(r, n, i) ||
+        !can_insert_at(r, n, i))
       continue;
-    }
-    double cost = d[after->id][n->id] + d[n->id][after->next->id] -
-                  mu * d[after->id][after->next->id];  // distance
+    int pred = a->ids[i], succ = a->ids[i + 1];
+    double cost = get_dist(pb, pred, n->id) +
+                  get_dist(pb, n->id, succ) -
+                  mu * get_dist(pb, pred, succ);  // distance
     if (alpha2) {
       cost *= alpha;
-      double est_node = max(n->est, after->aest + c_m[after->id][n->id]);
-      double est_succ = max(after->next->aest, est_node +
-                        c_m[n->id][after->next->id]);
-      cost = alpha2 * (est_succ - after->next->aest);
+      double est_node = max(n->est, a->aest[i] +
+                            get_cost(pb, workers, pred, n->id));
+      double est_succ = max(a->aest[i + 1], est_node +
+                        get_cost(pb, workers, n->id, succ));
+      cost = alpha2 * (est_succ - a->aest[i + 1]);
     }
-    double attract = lambda * d[DEPOT][n->id] - cost;
+    double attract = lambda * get_dist(pb, DEPOT, n->id) - cost;
     if (attract < 0.0)
       attract = MIN_DELTA;
-    if (!ins) {
-      ins = (Insertion *) s_malloc(sizeof(Insertion));
-      ins->attractiveness = -INFINITY;
-    }
+    found = 1;
     if (attract > ins->attractiveness) {
-      *ins = (Insertion) {.after = after, .attractiveness = attract,
+      *ins = (Insertion) {.after = a->nodes[i], .attractiveness = attract,
         .cost = cost, .node = n, .target = r,
         .next = (Insertion*) NULL, .prev = (Insertion*) NULL};
     }
-    after = after->next;
   }
-  return ins;
+  return found;
+}
+
+
+//! Return the least number of workers the route is feasible with.
+//! The earliest start times for all numbers of workers are propagated in a
+//! single pass over the route. As fewer workers never allow earlier starts,
+//! every count below one that violates a time window is infeasible as well.
+//! The result is cached until the route's nodes change.
+int get_min_workers(Route* route) {
+  Route_Array* a = &route->arr;
+  if (a->min_workers) return a->min_workers;
+  const Problem* pb = route->pb;
+  int max_workers = a->max_workers;
+  double aest[max_workers + 1];
+  int min_workers = 1;
+  for (int w = 1; w <= max_workers; ++w)
+    aest[w] = a->est[0];
+  for (int i = 1; i < route->len && min_workers <= max_workers; ++i) {
+    for (int w = min_workers; w <= max_workers; ++w) {
+      aest[w] = max(a->est[i], aest[w] +
+                    get_cost(pb, w, a->ids[i - 1], a->ids[i]));
+      if (aest[w] > a->lst[i]) min_workers = w + 1;
+    }
+  }
+  if (min_workers > max_workers)  // should not happen for feasible routes
+    min_workers = max_workers;
+  a->min_workers = min_workers;
+  return min_workers;
+}
+
+
+//! Return the position of the given node on the route.
+//! The opening depot is at position 0, the closing depot at route->len - 1.
+int get_position(const Route* route, const Node* n) {
+  Node* const* nodes = route->arr.nodes;
+  int i = 0;
+  #ifdef DEBUG
+  for (; i < route->len; ++i)
+    if (nodes[i] == n) return i;
+  fprintf(stderr, "ERROR: get_position: node %d not on route\n", n->id);
+  exit(EXIT_FAILURE);
+  #endif // DEBUG
+  while (nodes[i] != n)
+    i++;
+  return i;
 }
 
 
-//! Initialize or reset an insertion list.
-void init_insertion_list(Insertion_List* il, long max_size) {
-  if (!max_size) max_size = LONG_MAX;  // not limited
-  il->head = (Insertion*) NULL;
-  il->tail = (Insertion*) NULL;
+//! Initialize an insertion list and allocate its (fixed) capacity.
+//! \param max_size Maximum number of kept insertions (0 means unlimited).
+//! \param max_candidates Upper bound for the number of insertions offered
+//!   between two resets; limits the capacity of an unlimited list.
+void init_insertion_list(Insertion_List* il, long max_size,
+                         long max_candidates) {
+  if (!max_size || max_size > max_candidates)
+    max_size = max_candidates;  // the list can't grow any larger
+  if (max_size < 1) max_size = 1;
+  il->items = (Insertion*) s_malloc(sizeof(Insertion) * (size_t) max_size);
   il->size = 0;
   il->max_size = max_size;
 }
@@ -311,13 +464,13 @@ void init_insertion_list(Insertion_List* il, long max_size) {
 //! at the end of the overall computation. The known values for the
 //! earliest start times etc are not used in order to assure there are no bugs.
 int is_feasible(Route* r) {
-  double **c_m = r->pb->c_m[r->workers];
+  const Problem *pb = r->pb;
   Node *n = r->nodes->next;
   double load = 0.0;
   double est = r->nodes->est;
   while (n) {
     load += n->demand;
-    est = max(n->est, est + c_m[n->prev->id][n->id]);
+    est = max(n->est, est + get_cost(pb, r->workers, n->prev->id, n->id));
     if (est > n->lst) {
       fprintf(stderr, "time window collision at node %d\n", n->id);
       print_route(stderr, r);
@@ -325,9 +478,9 @@ int is_feasible(Route* r) {
     }
     n = n->next;
   }
-  if (load > r->pb->capacity) {
+  if (load > r->pb->inst->capacity) {
     fprintf(stderr, "route exceeds its capacity (%f/%u)\n", r->load,
-            r->pb->capacity);
+            r->pb->inst->capacity);
     print_route(stderr, r);
     return 0;
   }
@@ -357,43 +510,34 @@ int is_feasible_with(Route *route, int workers) {
 //! Return a pointer to a randomly selected insertion.
 //! If use_weights is set, return a pointer to an insertion selected by a
 //! weighted roulette wheel.
-//! The insertion is not removed from the list of insertions which is supposed
-//! to be done by route::remove_invalid_insertions or
-//! route::reset_insertion_list.
+//! The insertion is not removed from the list and remains valid until the
+//! list is updated or reset (see route::reset_insertion_list).
 //! Important: the roulette wheel is coded such that all attractivenesses have
 //! to be positive!
-//! \param il Doubly linked list of insertions.
-Insertion *pick_insertion(Insertion_List* il, int use_weights) {
-  Insertion *ins = il->head;
-  if (!ins) return ins;
+Insertion *pick_insertion(Insertion_List* il, int use_weights, Rng* rng) {
+  if (!il->size) return (Insertion*) NULL;
   if (use_weights) {
     double cum_attractiveness = 0.0;
-    while (ins) {
-      cum_attractiveness += ins->attractiveness;
-      ins = ins->next;
+    for (long i = 0; i < il->size; ++i) {
+      cum_attractiveness += il->items[i].attractiveness;
     }
-    ins = il->head;
-    double threshold = drand48() * cum_attractiveness;
-    while (ins) {
-      cum_attractiveness -= ins->attractiveness;
-      if (threshold >= cum_attractiveness) return ins;
-      ins = ins->next;
+    double threshold = rand_uniform(rng) * cum_attractiveness;
+    for (long i = 0; i < il->size; ++i) {
+      cum_attractiveness -= il->items[i].attractiveness;
+      if (threshold >= cum_attractiveness) return &il->items[i];
     }
     fprintf(stderr, "ERROR: pick_insertion: no insertion picked\n");
     fprintf(stderr, "ERROR: are there negative attractivenesses?");
     exit(EXIT_FAILURE);
   } else {
-    int index = (int) (lrand48() % il->size);
-    while (index--)
-      ins = ins->next;
-    return ins;
+    return &il->items[rand_long(rng) % il->size];
   }
 }
 
 
 // TODO: document & compare to _aco_
 Insertion* pick_insertion_from_array(Insertion insertions[],
-                                     int num_insertions) {
+                                     int num_insertions, Rng* rng) {
   double cum_attractiveness = 0.0;
   Insertion* ins = (Insertion*) NULL;
   double threshold = 0.0;
@@ -402,7 +546,7 @@ Insertion* pick_insertion_from_array(Insertion insertions[],
     if (isinf(insertions[i].attractiveness)) continue;
     cum_attractiveness += insertions[i].attractiveness;
   }
-  threshold = drand48() * cum_attractiveness;
+  threshold = rand_uniform(rng) * cum_attractiveness;
   for (int i = 0; i < num_insertions; ++i) {
     if (isinf(insertions[i].attractiveness)) continue;
     cum_attractiveness -= insertions[i].attractiveness;
@@ -430,24 +574,21 @@ void print_route(FILE* stream, Route* route)
 
 
 //! Remove unnecessary service workers from the given route.
+//! The number of workers needed is taken from get_min_workers.
 int reduce_service_workers(Route *route) {
-  int reduced = 0;
-  int workers = route->workers - 1;
-  Node *n = route->nodes;
-  while (workers >= 1 && is_feasible_with(route, workers)) {
-    route->workers = workers;
-    n = route->nodes;
-    while (n) {
-      n->aest = n->aest_cache;
-      n = n->next;
-    }
-    workers--;
-    reduced = 1;
-  }
-  if (reduced) {
-    calc_lsts(route, route->tail, route->workers);
+  int workers = get_min_workers(route);
+  Route_Array *a = &route->arr;
+  if (workers >= route->workers) return 0;
+  calc_ests(route, route->nodes, workers);  // fill the cache
+  journal_route(route);
+  route->workers = workers;
+  for (int i = 0; i < route->len; ++i) {
+    a->nodes[i]->aest = a->nodes[i]->aest_cache;
+    a->aest[i] = a->nodes[i]->aest;
   }
-  return reduced;
+  route->dirty = true;
+  calc_lsts(route, route->tail, route->workers);
+  return 1;
 }
 
 
@@ -507,25 +648,16 @@ void remove_nodes(Route* r, Node* first, Node* last) {
 
 
 //! Remove consecutive nodes and a worker from the given route.
-//! Must not be run unless move_reduces_workers was run with the same
-//! arguments before.
+//! Must not be run unless the nodes' aest_cache values hold the earliest
+//! starting times of the route without first to last (see is_feasible_with).
 //! \param num_workers Number of workers to remove.
 void remove_nodes_and_workers(Route* route, Node* first, Node* last,
                               int num_workers) {
-  Node* n = first;
-  do {
-    route->load -= n->demand;
-    route->len--;
-    n = n->next;
-  } while (n != last->next);
-  first->prev->next = last->next;
-  last->next->prev = first->prev;
-  last->next = (Node *) NULL;
-  first->prev = (Node *) NULL;
-  n = route->nodes;
-  while (n) {
-    n->aest = n->aest_cache;
-    n = n->next;
+  Route_Array *a = &route->arr;
+  remove_nodes_noupdate(route, first, last);
+  for (int i = 0; i < route->len; ++i) {
+    a->nodes[i]->aest = a->nodes[i]->aest_cache;
+    a->aest[i] = a->nodes[i]->aest;
   }
   route->workers -= num_workers;
   calc_lsts(route, route->tail, route->workers);
@@ -535,12 +667,24 @@ void remove_nodes_and_workers(Route* route, Node* first, Node* last,
 //! Remove one or more nodes from the given route.
 //! Do not update the ests and lsts.
 inline void remove_nodes_noupdate(Route* r, Node* first, Node* last) {
+  journal_route(r);
+  int pos = get_position(r, first);
+  int count = 0;
   Node* n = first;
+  uint64_t hash = arc_key(first->prev->id, first->id) ^
+                  arc_key(last->id, last->next->id) ^
+                  arc_key(first->prev->id, last->next->id);
   do {
     r->load -= n->demand;
-    r->len--;
+    count++;
+    if (n != last)
+      hash ^= arc_key(n->id, n->next->id);
     n = n->next;
   } while (n != last->next);
+  r->hash ^= hash;
+  move_entries(&r->arr, pos, &r->arr, pos + count, r->len - pos - count);
+  r->len -= count;
+  r->dirty = true;
   first->prev->next = last->next;
   last->next->prev = first->prev;
   last->next = (Node *) NULL;
@@ -548,21 +692,45 @@ inline void remove_nodes_noupdate(Route* r, Node* first, Node* last) {
 }
 
 
-//! Reset the given insertion list to its initial values.
-//! If it contained any insertions, free them.
+//! Reset the given insertion list to contain no insertions.
+//! The list's memory is kept.
 void reset_insertion_list(Insertion_List* il) {
-  if (il->head)
-    free_insertions(il->head);
-  init_insertion_list(il, il->max_size);
+  il->size = 0;
+}
+
+
+//! Restore a route from a state saved by copy_route within its solution.
+//! Unlike copy_route, the route's nodes are relinked and their actual start
+//! times are restored as well.
+void restore_route(Route* route, const Route* saved) {
+  copy_route(route, saved, route->sol->arena, route->sol->arena);
+  const Route_Array* a = &route->arr;
+  int last = route->len - 1;
+  for (int i = 0; i <= last; ++i) {
+    Node* n = a->nodes[i];
+    n->prev = i ? a->nodes[i - 1] : (Node*) NULL;
+    n->next = i < last ? a->nodes[i + 1] : (Node*) NULL;
+    n->aest = a->aest[i];
+    n->alst = a->alst[i];
+  }
 }
 
 
 //! Swap n1 and n2 and update r1 and r2 accordingly.
 //! No checks are performed.
 void swap(Route* r1, Route* r2, Node* n1, Node* n2) {
+  journal_route(r1);
+  journal_route(r2);
+  int pos1 = get_position(r1, n1);
+  int pos2 = get_position(r2, n2);
   Node* temp = n1->prev;
   r1->load += n2->demand - n1->demand;
   r2->load += n1->demand - n2->demand;
+  r1->dirty = r2->dirty = true;
+  r1->hash ^= arc_key(n1->prev->id, n1->id) ^ arc_key(n1->id, n1->next->id) ^
+              arc_key(n1->prev->id, n2->id) ^ arc_key(n2->id, n1->next->id);
+  r2->hash ^= arc_key(n2->prev->id, n2->id) ^ arc_key(n2->id, n2->next->id) ^
+              arc_key(n2->prev->id, n1->id) ^ arc_key(n1->id, n2->next->id);
 
   n1->prev = n2->prev;
   n2->prev = temp;
@@ -579,6 +747,8 @@ void swap(Route* r1, Route* r2, Node* n1, Node* n2) {
   n1->next->aest = n1->next->aest_cache;  // next node is already updated
   n2->aest = n2->aest_cache;
   n2->next->aest = n2->next->aest_cache;
+  fill_entries(&r1->arr, pos1, n2, 2);  // n2 and its (updated) successor
+  fill_entries(&r2->arr, pos2, n1, 2);
   if (n1->next->next && n1->next->next->next)  // don't update the closing depot
     calc_ests(r2, n1->next->next, r2->workers);
   if (n2->next->next && n2->next->next->next)
@@ -605,73 +775,54 @@ void print_insertion_list(Insertion *ins) {
 }
 
 
-//! Add `ins` to the insertion list and remove the worst element if needed.
-//! Ins has to be added to the correct position (sorted by attractiveness,
-//! where the head is the most attractive element. If
-//! the size would grow
-//! beyond il->max_size, the worst element has to be freed and the pointers
-//! need to be updated accordingly.
+//! Add a copy of `ins` to the insertion list.
+//! The insertions are sorted by attractiveness, where items[0] is the most
+//! attractive one. Insertions with the same attractiveness are kept in the
+//! order they were added. If the list is full, the least attractive
+//! insertion is dropped (the one added last if several are equally bad) unless
+//! `ins` is even less attractive.
 //! \return 1 if `ins` was inserted, otherwise 0.
-// TODO: rewrite properly and cleanly
-int update_insertion_list(Insertion_List* il, Insertion* ins) {
-  if (!il->size) {  // the first element
-    il->head = ins;
-    il->tail = ins;
-    il->size++;
-    return 1;
-  }
-  if (il->max_size == 1) {
-    if (il->head->attractiveness > ins->attractiveness) {
-      free(ins);
-      return 0;
-    } else {
-      free(il->head);
-      il->head = ins;
-      il->tail = ins;
-      return 1;
-    }
-  }
+int update_insertion_list(Insertion_List* il, const Insertion* ins) {
+  Insertion* items = il->items;
+  long pos = il->size;
+  while (pos && items[pos - 1].attractiveness < ins->attractiveness)
+    pos--;  // pos is behind all insertions that are at least as attractive
   if (il->size < il->max_size) {
-    if (il->head->attractiveness < ins->attractiveness) {  // ins is head
-      ins->next = il->head;
-      il->head->prev = ins;
-      il->head = ins;
-      il->size++;
-      return 1;
-    }
-    Insertion* temp = il->tail;
-    while (temp->attractiveness < ins->attractiveness)
-      temp = temp->prev;
-    if (temp == il->tail) {
-      il->tail = ins;
-    } else {
-      ins->next = temp->next;
-      temp->next->prev = ins;
-    }
-    temp->next = ins;
-    ins->prev = temp;
     il->size++;
   } else {
-    if (il->tail->attractiveness > ins->attractiveness) {
-      free(ins);
+    if (items[il->size - 1].attractiveness > ins->attractiveness)
       return 0;
-    } else if (il->head->attractiveness < ins->attractiveness) {
-      ins->next = il->head;
-      il->head->prev = ins;
-      il->head = ins;
-    } else {
-      Insertion* temp = il->tail->prev;
-      while (temp->attractiveness < ins->attractiveness)
-        temp = temp->prev;
-      ins->next = temp->next;
-      ins->next->prev = ins;
-      ins->prev = temp;
-      temp->next = ins;
-    }
-    Insertion* temp = il->tail->prev;
-    free(il->tail);
-    il->tail = temp;
-    il->tail->next = (Insertion*) NULL;
+    if (pos == il->size)  // as bad as the worst; replace it
+      pos--;
   }
+  memmove(items + pos + 1, items + pos,
+          sizeof(Insertion) * (size_t) (il->size - 1 - pos));
+  items[pos] = *ins;
   return 1;
 }
+
+
+//! Recalculate the route's segment summaries (arr.fwd and arr.bwd) for all
+//! numbers of workers unless they are up to date.
+//! Unlike reading the summaries, this is not safe to call concurrently.
+void update_segments(Route* route) {
+  Route_Array* a = &route->arr;
+  if (a->segments_valid) return;
+  const Problem* pb = route->pb;
+  int last = route->len - 1;
+  for (int w = 1; w <= a->max_workers; ++w) {
+    Segment* fwd = a->fwd + (w - 1) * a->capacity;
+    Segment* bwd = a->bwd + (w - 1) * a->capacity;
+    fwd[0] = node_segment(a->nodes[0]);
+    for (int i = 1; i <= last; ++i)
+      fwd[i] = concat_segments(fwd[i - 1], get_cost(pb, w, a->ids[i - 1],
+                                                    a->ids[i]),
+                               node_segment(a->nodes[i]));
+    bwd[last] = node_segment(a->nodes[last]);
+    for (int i = last - 1; i >= 0; --i)
+      bwd[i] = concat_segments(node_segment(a->nodes[i]),
+                               get_cost(pb, w, a->ids[i], a->ids[i + 1]),
+                               bwd[i + 1]);
+  }
+  a->segments_valid = true;
+}
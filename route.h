@@ -9,6 +9,7 @@
 #define ROUTE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -27,6 +28,33 @@ enum RouteLength {
   TWO_CUSTOMERS,
 };
 
+//! \struct route_array
+//! Structure of arrays representation of a route's nodes.
+//! Entry i describes the i-th node on the route; 0 is the opening and
+//! route->len - 1 the closing depot. Insertion scans and the propagation of
+//! the earliest and latest start times sweep these arrays instead of chasing
+//! the nodes' next and prev pointers.
+//! The arrays are maintained by the route's splice operations (add_nodes,
+//! remove_nodes, swap, ...). Code that relinks a route's nodes directly has
+//! to restore the original list before calling any other route function.
+//! The segment summaries fwd and bwd and min_workers are only recalculated
+//! on demand (see update_segments and get_min_workers).
+struct route_array {
+  double* aest;  //!< Actual earliest start times (mirrors node->aest).
+  double* alst;  //!< Actual latest start times (mirrors node->alst).
+  double* est;
+  double* lst;
+  double* demand;
+  Segment* fwd;  //!< Summaries of the nodes 0 to i (per number of workers).
+  Segment* bwd;  //!< Summaries of the nodes i to len - 1 (per workers).
+  Node** nodes;  //!< The nodes themselves (the results are written back).
+  int* ids;
+  int capacity;  //!< Number of entries the arrays can hold.
+  int max_workers;  //!< Number of worker counts with segment summaries.
+  int min_workers;  //!< Least feasible number of workers (0 if unknown).
+  bool segments_valid;  //!< False once the nodes changed.
+};
+
 enum Weights {
   NO_WEIGHTS,
   USE_WEIGHTS,
@@ -42,6 +70,8 @@ enum Weights {
 //!   <li>adding/ removing of nodes is faster & safer</li>
 //!   <li>initialization of routes becomes faster</li>
 //! </ul>
+//! In addition, the route keeps a structure of arrays copy of its nodes
+//! (see route_array) which is used by the hot kernels.
 struct route {
   int id;  //!< Starts with 0 and is unique unless the route is cloned.
   int depot_id;  //!< Starting with num_nodes (+0 for the first route).
@@ -51,7 +81,15 @@ struct route {
             //!< (the total distance is not stored).
   double load;  //!< The truck's (route's) current load.
   int workers;  //!< The number of workers currently assigned to this route.
+  //! Set whenever the route's nodes or workers change; cleared by the local
+  //! search once it has evaluated the route (see local_search::start_pass).
+  bool dirty;
+  //! The XOR of the keys of all arcs on the route (see arc_key); maintained
+  //! by the route's splice operations.
+  uint64_t hash;
   Problem *pb;
+  Solution *sol;  //!< The solution owning the route's slot.
+  Route_Array arr;  //!< Contiguous copy of the nodes (len entries).
 };
 
 struct insertion {
@@ -64,12 +102,14 @@ struct insertion {
   Insertion* prev;  //!< Previous insertion in insertion list.
 };
 
-//! A list of insertions that can be sorted.
+//! A bounded list of insertions sorted by attractiveness (eg. GRASP's
+//! restricted candidate list).
+//! The insertions are stored by value in an array that is allocated once by
+//! init_insertion_list; updating and resetting the list does not allocate.
 struct insertion_list {
-  Insertion* head;  //!< Head of the insertion list.
-  Insertion* tail;  //!< Tail of the insertion list.
-  long size;
-  long max_size;
+  Insertion* items;  //!< Sorted insertions (items[0] is the most attractive).
+  long size;  //!< Number of insertions currently in the list.
+  long max_size;  //!< Capacity of items.
 };
 
 Route* new_route(Solution*, Node*, int workers);
@@ -79,15 +119,20 @@ int calc_best_insertion(Route*, Node*, Insertion*);
 void calc_ests(Route*, Node*, int workers);
 void calc_lsts(Route*, Node*, int workers);
 double calc_length(Route*);
-Route *clone_route(Route* route);
+void copy_route(Route* dst, const Route* src, Node* arena,
+                const Node* src_arena);
+void free_insertion_list(Insertion_List* il);
 void free_route(Route* route);
-Insertion* get_best_insertion(Route*, Node*);
-void init_insertion_list(Insertion_List* il, long max_size);
+int get_best_insertion(Route*, Node*, Insertion*);
+int get_min_workers(Route*);
+int get_position(const Route*, const Node*);
+void init_insertion_list(Insertion_List* il, long max_size,
+                         long max_candidates);
 int is_feasible(Route*);
 int is_feasible_with(Route*, int workers);
 // int move_best_node(Route* source, Route* target, int state);
-Insertion* pick_insertion(Insertion_List* il, int use_weights);
-Insertion* pick_insertion_from_array(Insertion[], int num_insertions);
+Insertion* pick_insertion(Insertion_List* il, int use_weights, Rng*);
+Insertion* pick_insertion_from_array(Insertion[], int num_insertions, Rng*);
 void print_route(FILE* stream, Route*);
 int reduce_service_workers(Route*);
 Insertion *remove_invalid_insertions(Insertion* old, Insertion* ins)
@@ -96,8 +141,10 @@ void remove_nodes(Route*, Node* first, Node* last);
 void remove_nodes_and_workers(Route*, Node* first, Node* last, int);
 extern void remove_nodes_noupdate(Route*, Node* first, Node* last);
 void reset_insertion_list(Insertion_List* il);
+void restore_route(Route* route, const Route* saved);
 void swap(Route* r1, Route* r2, Node* n1, Node* n2);
-int update_insertion_list(Insertion_List* il, Insertion* ins);
+int update_insertion_list(Insertion_List* il, const Insertion* ins);
+void update_segments(Route*);
 
 
 
@@ -105,7 +152,7 @@ int update_insertion_list(Insertion_List* il, Insertion* ins);
 //! Return True if the suggested insertion is feasible.
 //! An insertion is feasible if there is no collision in the earliest and latest
 //! start times. The approach used in this function is faster than the more
-//! straight-forward approach of using max(est, pred->aest + c_m[...]).
+//! straight-forward approach of using max(est, pred->aest + get_cost(...)).
 //! The total load is not checked by this function.
 static inline bool can_insert_one(Route *route, Node *n, Node *pred) {
   #ifdef DEBUG
@@ -119,31 +166,117 @@ static inline bool can_insert_one(Route *route, Node *n, Node *pred) {
     exit(EXIT_FAILURE);
   }
   #endif // DEBUG
-  double **c_m = route->pb->c_m[route->workers];
-  double earliest_arrival = pred->aest + c_m[pred->id][n->id];
-  double latest_arrival = pred->next->alst - c_m[n->id][pred->next->id];
+  const Problem* pb = route->pb;
+  int workers = route->workers;
+  if (!can_follow(pb, workers, pred->id, n->id) ||
+      !can_follow(pb, workers, n->id, pred->next->id))
+    return false;
+  double earliest_arrival = pred->aest + get_cost(pb, workers, pred->id, n->id);
+  double latest_arrival = pred->next->alst -
+                          get_cost(pb, workers, n->id, pred->next->id);
+  return (earliest_arrival <= n->lst) && (latest_arrival >= n->est) &&
+    (earliest_arrival <= latest_arrival);
+}
+
+
+//! Return True if n can be inserted between the nodes at pos and pos + 1.
+//! Array based equivalent of can_insert_one.
+static inline bool can_insert_at(const Route *route, const Node *n, int pos) {
+  const Route_Array* a = &route->arr;
+  const Problem* pb = route->pb;
+  int workers = route->workers;
+  if (!can_follow(pb, workers, a->ids[pos], n->id) ||
+      !can_follow(pb, workers, n->id, a->ids[pos + 1]))
+    return false;
+  double earliest_arrival = a->aest[pos] +
+                            get_cost(pb, workers, a->ids[pos], n->id);
+  double latest_arrival = a->alst[pos + 1] -
+                          get_cost(pb, workers, n->id, a->ids[pos + 1]);
   return (earliest_arrival <= n->lst) && (latest_arrival >= n->est) &&
     (earliest_arrival <= latest_arrival);
 }
 
 
-// TODO name properly and move to proper location;
-// profile in comparison to insert_feasible
-#include <math.h>
-static inline bool can_insert(Route* target, Node* first, Node* last,
-                             Node* after) {
-  double **c_m = target->pb->c_m[target->workers];  // driving + service time
-  first->aest_cache = max(after->aest + c_m[after->id][first->id], first->est);
-  if (first->aest_cache > first->lst) return 0;
+//! Return True if inserting n between the nodes at pos and pos + 1 links n to
+//! at least one of its granular neighbours.
+static inline bool is_granular_position(const Route *route, const Node *n,
+                                        int pos) {
+  const int* ids = route->arr.ids;
+  return is_neighbour(route->pb, n->id, ids[pos]) ||
+         is_neighbour(route->pb, n->id, ids[pos + 1]);
+}
+
+
+//! Return the summary of the nodes first to last for the given number of
+//! workers. The nodes don't need to be on a route.
+static inline Segment get_segment(const Problem* pb, const Node* first,
+                                  const Node* last, int workers) {
+  Segment s = node_segment(first);
   while (first != last) {
-    Node* next = first->next;
-    next->aest_cache = max(first->aest_cache + c_m[first->id][next->id],
-                            next->est);
-    if (next->aest_cache > next->lst) return 0;
-    first = next;
+    s = concat_segments(s, get_cost(pb, workers, first->id, first->next->id),
+                        node_segment(first->next));
+    first = first->next;
   }
-  return ((last->aest_cache + c_m[last->id][after->next->id]) <=
-          after->next->alst);
+  return s;
+}
+
+
+//! Return a well mixed version of x (the splitmix64 finalizer).
+static inline uint64_t mix_hash(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+
+//! Return the Zobrist key of the arc from node i to node j.
+//! The keys are derived from the node ids instead of being drawn from a table;
+//! hence, they take no memory and are the same for all runs.
+static inline uint64_t arc_key(int i, int j) {
+  return mix_hash(((uint64_t) (uint32_t) i << 32 | (uint32_t) j) +
+                  0x9e3779b97f4a7c15ULL);
+}
+
+
+//! Return the summary of the route's nodes 0 to pos.
+//! The summaries have to be up to date (see update_segments).
+static inline const Segment* get_prefix(const Route* route, int workers,
+                                        int pos) {
+  return route->arr.fwd + (workers - 1) * route->arr.capacity + pos;
+}
+
+
+//! Return the summary of the route's nodes pos to route->len - 1.
+//! The summaries have to be up to date (see update_segments).
+static inline const Segment* get_suffix(const Route* route, int workers,
+                                        int pos) {
+  return route->arr.bwd + (workers - 1) * route->arr.capacity + pos;
+}
+
+
+//! Return True if a sequence of nodes can be inserted between the nodes at
+//! pos and pos + 1 of target.
+//! The check takes constant time as the route's aests and alsts summarize
+//! the nodes before and after the insertion.
+//! Neither route is modified; hence, concurrent calls are safe as long as the
+//! routes are not changed.
+//! \param seq The sequence's summary for target's number of workers.
+//! \param first The id of the sequence's first node.
+//! \param last The id of the sequence's last node.
+static inline bool can_insert(const Route* target, const Segment* seq,
+                              int first, int last, int pos) {
+  const Problem* pb = target->pb;
+  const Route_Array* a = &target->arr;
+  int workers = target->workers;  // driving + service time
+  if (!seq->feasible ||
+      !can_follow(pb, workers, a->ids[pos], first) ||
+      !can_follow(pb, workers, last, a->ids[pos + 1]))
+    return 0;
+  double arrival = a->aest[pos] + get_cost(pb, workers, a->ids[pos], first);
+  if (arrival > seq->latest) return 0;
+  double aest = max(arrival, seq->earliest) + seq->duration;  // at last
+  return ((aest + get_cost(pb, workers, last, a->ids[pos + 1]))
+          <= a->alst[pos + 1]);
 }
 
 
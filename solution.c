@@ -7,6 +7,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "config.h"
 #include "node.h"
@@ -19,6 +20,43 @@
 ///////////////////////////////////////////////////////////////////////////////
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
+static void close_journal(Journal* j);
+static inline Node* rebase(Node* n, Node* arena, const Node* src_arena);
+static void release_route(Solution* sol, Route* route);
+static void reset_free_slots(Solution* sol);
+
+
+//! End the journal's checkpoint and forget the saved states.
+static void close_journal(Journal* j) {
+  for (int i = 0; i < j->num_saved; ++i)
+    j->is_saved[j->slots[i]] = false;
+  j->num_saved = 0;
+  j->routes_saved = false;
+  j->active = false;
+}
+
+
+//! Return the address of the node in arena that corresponds to n.
+//! \param n A node in src_arena or NULL.
+static inline Node* rebase(Node* n, Node* arena, const Node* src_arena) {
+  return n ? arena + (n - src_arena) : n;
+}
+
+
+//! Return the given route's slot to the solution's unused route slots.
+static void release_route(Solution* sol, Route* route) {
+  sol->free_slots[sol->num_free_slots++] = (int) (route - sol->route_pool);
+}
+
+
+//! Mark all route slots as unused (slot 0 is the next to be acquired).
+static void reset_free_slots(Solution* sol) {
+  int num_slots = sol->pb->inst->num_nodes;
+  for (int i = 0; i < num_slots; ++i) {
+    sol->free_slots[i] = num_slots - 1 - i;
+  }
+  sol->num_free_slots = num_slots;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -26,48 +64,85 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 //! "Constructor".
+//! The solution's storage is allocated for one route per node (it is never
+//! required to grow).
 Solution* new_solution(Problem *pb) {
   Solution *sol = (Solution *) s_malloc(sizeof(Solution));
   sol->pb = pb;
-  int num_nodes = sol->pb->num_nodes;
-  Node **nodes = sol->pb->nodes;
+  sol->rng = &pb->rng;
+  sol->evaluator = pb->evaluator;
+  int num_nodes = sol->pb->inst->num_nodes;
+  Node **nodes = sol->pb->inst->nodes;
   Node *tail = (Node *) NULL;
   sol->num_unrouted = num_nodes - 1;
-  // allocate space for pointers to one route per node
-  sol->routes = (Route**) s_malloc(sizeof(Route*) *
-  (size_t) (num_nodes - 1));  // exclude the depot
+  // don't use fewer slots b/c the solution might be reset and use more
+  // trucks in a future run
+  sol->routes = (Route**) s_malloc(sizeof(Route*) * (size_t) num_nodes);
+  sol->route_pool = (Route*) s_malloc(sizeof(Route) * (size_t) num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    sol->route_pool[i].arr.aest = (double*) NULL;
+    sol->route_pool[i].arr.capacity = 0;
+    sol->route_pool[i].sol = sol;
+  }
+  sol->journal.active = false;
+  sol->journal.saved = (Route*) NULL;  // allocated by checkpoint_solution
+  sol->free_slots = (int*) s_malloc(sizeof(int) * (size_t) num_nodes);
+  reset_free_slots(sol);
+  // the customers plus two depots per route slot
+  sol->arena = (Node*) s_malloc(sizeof(Node) * (size_t) (3 * num_nodes));
   sol->trucks = 0;
   sol->time = 0;
   sol->saturation_time = 0;
   sol->workers_cache = 0;
   sol->dist_cache = 0.0;
-  sol->unrouted = clone_node(nodes[1]);
-  sol->unrouted->prev = (Node*) NULL;
-  sol->unrouted->next = (Node*) NULL;
+  copy_node(&sol->arena[DEPOT], nodes[DEPOT]);  // unused; keeps copies simple
+  sol->unrouted = &sol->arena[1];
+  copy_node(sol->unrouted, nodes[1]);
   tail = sol->unrouted;
   for (int i = 2; i < num_nodes; i++) { // skip depot and first node
-    tail->next = clone_node(nodes[i]);
+    copy_node(&sol->arena[i], nodes[i]);
+    tail->next = &sol->arena[i];
     tail->next->prev = tail;
-    tail->next->next = (Node*) NULL;
     tail = tail->next;
   }
   return sol;
 }
 
 
+//! Return an unused route slot of the solution.
+//! The route's opening and closing depot (nodes and tail) are initialized but
+//! not linked to any other node. All other members need to be set by the
+//! caller.
+Route* acquire_route(Solution* sol) {
+  #ifdef DEBUG
+  if (!sol->num_free_slots) {
+    fprintf(stderr, "ERROR: acquire_route: no unused route slot left\n");
+    exit(EXIT_FAILURE);
+  }
+  #endif // DEBUG
+  int slot = sol->free_slots[--sol->num_free_slots];
+  Route* route = &sol->route_pool[slot];
+  route->nodes = &sol->arena[sol->pb->inst->num_nodes + 2 * slot];
+  route->tail = route->nodes + 1;
+  copy_node(route->nodes, sol->pb->inst->nodes[DEPOT]);
+  copy_node(route->tail, sol->pb->inst->nodes[DEPOT]);
+  return route;
+}
+
+
 //! Interrupt unless the solution is feasible.
 //! Feasibility implies that all routes are feasible and all customers are
 //! served exactly once.
 void assert_feasibility(Solution *sol) {
   int feasible = 1;
   Node *n = (Node *) NULL;
-  int num_nodes = sol->routes[0]->pb->num_nodes; // includes the depot
+  int num_nodes = sol->routes[0]->pb->inst->num_nodes; // includes the depot
   if (!sol->routes[0]) {
     printf("sol_is_feasible: no routes in solution");
     exit(EXIT_FAILURE);
   }
   char served[num_nodes];
-  Node **nodes = sol->routes[0]->pb->nodes;
+  Node **nodes = sol->routes[0]->pb->inst->nodes;
   served[0] = 1;  // no need to serve the depot
   for (int i = 1; i < num_nodes; ++i) {
     served[i] = 0;
@@ -138,48 +213,97 @@ int calc_workers(Solution* sol)
 }
 
 
+//! Start recording the solution's changes so that they can be undone.
+//! The changes are either undone by rollback_solution or kept by
+//! commit_solution.
+void checkpoint_solution(Solution* sol) {
+  Journal* j = &sol->journal;
+  #ifdef DEBUG
+  if (j->active) {
+    fprintf(stderr, "ERROR: checkpoint_solution: checkpoint is active\n");
+    exit(EXIT_FAILURE);
+  }
+  #endif // DEBUG
+  if (!j->saved) {
+    size_t num_slots = (size_t) sol->pb->inst->num_nodes;
+    j->saved = (Route*) s_malloc(sizeof(Route) * num_slots);
+    for (size_t i = 0; i < num_slots; ++i) {
+      j->saved[i].arr.aest = (double*) NULL;
+      j->saved[i].arr.capacity = 0;
+      j->saved[i].sol = sol;
+    }
+    j->is_saved = (bool*) s_malloc(sizeof(bool) * num_slots);
+    memset(j->is_saved, 0, sizeof(bool) * num_slots);
+    j->slots = (int*) s_malloc(sizeof(int) * num_slots);
+    j->routes = (Route**) s_malloc(sizeof(Route*) * num_slots);
+    j->num_saved = 0;
+    j->routes_saved = false;
+  }
+  j->active = true;
+  j->trucks = sol->trucks;
+  j->num_free_slots = sol->num_free_slots;
+  j->time = sol->time;
+  j->workers_cache = sol->workers_cache;
+  j->dist_cache = sol->dist_cache;
+  j->cost_cache = sol->cost_cache;
+}
+
+
 //! Clone a solution and return a pointer to the clone.
 //! The clone gets entirely new route objects.
 Solution* clone_solution(Solution* sol) {
-  Solution* clone = (Solution*) s_malloc(sizeof(Solution));
-  int num_nodes = sol->pb->num_nodes;
-  clone->pb = sol->pb;
-  clone->num_unrouted = sol->num_unrouted;
-  clone->trucks = sol->trucks;
-  clone->time = sol->time;
-  clone->saturation_time = sol->saturation_time;
-  clone->cost_cache = sol->cost_cache;
-  clone->dist_cache = sol->dist_cache;
-  clone->workers_cache = sol->workers_cache;
-  // don't do sizeof(Route *) * clone->trucks b/c the solution
-  // might be reset and use more trucks in a future run
-  // sizeof(Route *) * clone->num_unrouted doesn't work b/c
-  // num_unrouted is generally 0 after running the initial heuristic
-  clone->routes = (Route **) s_malloc(sizeof(Route *) * (size_t) num_nodes);
-  for (int i = 0; i < clone->trucks; ++i) {
-    clone->routes[i] = clone_route(sol->routes[i]);
+  Solution* clone = new_solution(sol->pb);
+  copy_solution(clone, sol);
+  return clone;
+}
+
+
+//! Keep all changes since the solution's checkpoint.
+void commit_solution(Solution* sol) {
+  close_journal(&sol->journal);
+}
+
+
+//! Copy the solution src to dst, reusing dst's storage.
+//! The customers are copied in bulk and the depots of src's routes
+//! slot by slot; afterwards, all node pointers are rebased to dst's arena.
+//! Both solutions must belong to the same problem.
+void copy_solution(Solution* dst, const Solution* src) {
+  int num_nodes = src->pb->inst->num_nodes;
+  Node* arena = dst->arena;
+  dst->num_unrouted = src->num_unrouted;
+  dst->trucks = src->trucks;
+  dst->time = src->time;
+  dst->saturation_time = src->saturation_time;
+  dst->cost_cache = src->cost_cache;
+  dst->dist_cache = src->dist_cache;
+  dst->workers_cache = src->workers_cache;
+  dst->num_free_slots = src->num_free_slots;
+  memcpy(dst->free_slots, src->free_slots, sizeof(int) * (size_t) num_nodes);
+  memcpy(arena, src->arena, sizeof(Node) * (size_t) num_nodes);
+  for (int i = 1; i < num_nodes; ++i) {
+    arena[i].prev = rebase(arena[i].prev, arena, src->arena);
+    arena[i].next = rebase(arena[i].next, arena, src->arena);
   }
-  clone->unrouted = (Node *) NULL;
-  if (sol->unrouted) {
-    Node* n = sol->unrouted;
-    clone->unrouted = clone_node(n);
-    Node* tail = clone->unrouted;
-    n = n->next;
-    while (n) {
-      tail->next = clone_node(n);
-      tail->next->prev = tail;
-      tail = tail->next;
-      n = n->next;
-    }
+  for (int i = 0; i < src->trucks; ++i) {
+    const Route* r = src->routes[i];
+    Route* route = &dst->route_pool[r - src->route_pool];
+    size_t depots = (size_t) (r->nodes - src->arena);
+    memcpy(&arena[depots], &src->arena[depots], 2 * sizeof(Node));
+    arena[depots].next = rebase(arena[depots].next, arena, src->arena);
+    arena[depots + 1].prev = rebase(arena[depots + 1].prev, arena,
+                                    src->arena);
+    copy_route(route, r, arena, src->arena);
+    dst->routes[i] = route;
   }
-  return clone;
+  dst->unrouted = rebase(src->unrouted, arena, src->arena);
 }
 
 
 //! Write a representation of the solution to the given filestream.
 void fprint_solution(FILE* stream, Solution* sol, Config* cfg, int verbose) {
   if (verbose) {
-    fprintf(stream, "%s\n", sol->pb->name);
+    fprintf(stream, "%s\n", sol->pb->inst->name);
     if (stream != stdout)
       fprint_config_summary(stream, cfg);
     fprint_performance(stream, sol->pb);
@@ -195,21 +319,27 @@ void fprint_solution(FILE* stream, Solution* sol, Config* cfg, int verbose) {
 
 //! Free the memory of the given solution and all allocated members.
 void free_solution(Solution* sol) {
-  Node *n = (Node *) NULL;
 #ifdef DEBUG
   if (sol->pb->cfg->verbosity >= FULL_DEBUG)
     printf("free_solution: trying to free %d routes\n", sol->trucks);
 #endif // DEBUG
-  for (int i = 0; i < sol->trucks; ++i) {
-    free_route(sol->routes[i]);
-    sol->routes[i] = (Route *) NULL;
+  int num_slots = sol->pb->inst->num_nodes;  // including unused slots
+  for (int i = 0; i < num_slots; ++i) {
+    free_route(&sol->route_pool[i]);
   }
-  free(sol->routes);
-  while (sol->unrouted) {
-    n = sol->unrouted;
-    remove_unrouted(sol, sol->unrouted);
-    free(n);
+  free(sol->route_pool);
+  if (sol->journal.saved) {
+    for (int i = 0; i < num_slots; ++i) {
+      free_route(&sol->journal.saved[i]);
+    }
+    free(sol->journal.saved);
+    free(sol->journal.is_saved);
+    free(sol->journal.slots);
+    free(sol->journal.routes);
   }
+  free(sol->free_slots);
+  free(sol->routes);
+  free(sol->arena);  // all routed and unrouted nodes
   free(sol);
 }
 
@@ -225,17 +355,54 @@ int get_route_index(Solution* sol, int route_id) {
 }
 
 
-//! Remove a route from the solution and free its memory.
+//! Return a fingerprint of the solution's structure.
+//! Two solutions have the same fingerprint if their routes visit the same
+//! nodes in the same order with the same numbers of workers (barring hash
+//! collisions). The routes' hashes are mixed and summed; hence, the order of
+//! the routes does not matter. Takes time linear in the number of routes.
+uint64_t hash_solution(const Solution* sol) {
+  uint64_t hash = 0;
+  for (int i = 0; i < sol->trucks; ++i) {
+    const Route* route = sol->routes[i];
+    hash += mix_hash(route->hash ^ (uint64_t) route->workers);
+  }
+  return hash;
+}
+
+
+//! Save the route's state unless it was already saved since the solution's
+//! checkpoint or no checkpoint is active (see Journal).
+//! Has to be called before the route changes.
+void journal_route(Route* route) {
+  Solution* sol = route->sol;
+  Journal* j = &sol->journal;
+  if (!j->active) return;
+  int slot = (int) (route - sol->route_pool);
+  if (j->is_saved[slot]) return;
+  copy_route(&j->saved[slot], route, sol->arena, sol->arena);
+  j->is_saved[slot] = true;
+  j->slots[j->num_saved++] = slot;
+}
+
+
+//! Remove a route from the solution and release its slot.
 //! Only use on empty routes (routes with only the depot).
+//! The following routes move forward and are marked dirty.
 void remove_route(Solution* sol, int route_idx) {
   if (!(sol->routes[route_idx]->len == EMPTY)) {  // non-empty route
     fprintf(stderr, "remove_route tried to remove non-empty route\n");
     exit(EXIT_FAILURE);
   }
-  free_route(sol->routes[route_idx]);
+  Journal* j = &sol->journal;
+  if (j->active && !j->routes_saved) {
+    memcpy(j->routes, sol->routes, sizeof(Route*) * (size_t) sol->trucks);
+    j->routes_saved = true;
+  }
+  release_route(sol, sol->routes[route_idx]);
   sol->trucks--;
   for (int i = route_idx; i < sol->trucks; ++i) {
     sol->routes[i] = sol->routes[i+1];
+    sol->routes[i]->dirty = true;  // its index changed
   }
   sol->routes[sol->trucks] = (Route *) NULL;
 }
@@ -269,7 +436,6 @@ void reset_solution(Solution* sol, int num_nodes) {
   for (int i = 0; i < sol->trucks; ++i) {
     Route* r = sol->routes[i];
     if (r->len == EMPTY) {
-      free_route(sol->routes[i]);
       sol->routes[i] = (Route *) NULL;
       continue;
     }
@@ -281,9 +447,9 @@ void reset_solution(Solution* sol, int num_nodes) {
     sol->unrouted->prev = (Node*) NULL;
     r->nodes->next = r->tail;  // there are only two depots left
     r->tail->prev = r->nodes;
-    free_route(sol->routes[i]);
     sol->routes[i] = (Route*) NULL;
   }
+  reset_free_slots(sol);
   sol->num_unrouted = num_nodes - 1;  // exclude the depot
   sol->trucks = 0;
   sol->workers_cache = 0;
@@ -293,6 +459,27 @@ void reset_solution(Solution* sol, int num_nodes) {
 }
 
 
+//! Undo all changes since the solution's checkpoint.
+void rollback_solution(Solution* sol) {
+  Journal* j = &sol->journal;
+  j->active = false;  // restoring the routes doesn't need to be recorded
+  for (int i = 0; i < j->num_saved; ++i) {
+    int slot = j->slots[i];
+    restore_route(&sol->route_pool[slot], &j->saved[slot]);
+  }
+  if (j->routes_saved) {
+    memcpy(sol->routes, j->routes, sizeof(Route*) * (size_t) j->trucks);
+  }
+  sol->trucks = j->trucks;
+  sol->num_free_slots = j->num_free_slots;
+  sol->time = j->time;
+  sol->workers_cache = j->workers_cache;
+  sol->dist_cache = j->dist_cache;
+  sol->cost_cache = j->cost_cache;
+  close_journal(j);
+}
+
+
 //! Save the details of a solution to a file.
 void save_solution_details(Solution* sol, Config* cfg) {
   FILE* outfile = fopen(cfg->sol_details_filename, "a");
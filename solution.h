@@ -8,16 +8,47 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "common.h"
 #include "config.h"
 
+//! \struct journal
+//! Undo information of a solution's trial modifications (see
+//! checkpoint_solution, rollback_solution and commit_solution).
+//! While a checkpoint is active, the first change of a route saves its state
+//! (see journal_route). Rolling back only restores the saved routes; hence,
+//! it takes time proportional to the work done instead of the solution's
+//! size. Code that changes a route's members directly (instead of using the
+//! route's functions) has to call journal_route first. Routes can't be added
+//! while a checkpoint is active and checkpoints can't be nested.
+struct journal {
+  bool active;  //!< True while a checkpoint is active.
+  Route* saved;  //!< The routes' saved states (indexed by route slot).
+  bool* is_saved;  //!< True for each route slot saved since the checkpoint.
+  int* slots;  //!< The route slots saved since the checkpoint.
+  int num_saved;
+  Route** routes;  //!< The routes at the checkpoint (saved before removals).
+  bool routes_saved;  //!< True once routes holds the routes.
+  int trucks;
+  int num_free_slots;
+  long int time;
+  int workers_cache;
+  double dist_cache;
+  double cost_cache;
+};
+
 //! \struct solution
 //! Stores a single solution to a VRPTWMS.
 //! The solution starts unsolved with all nodes in the list of unrouted nodes.
 //! A feasible solution must therefore not have any unrouted nodes.
 //! The cost, distance and workers are not permanently updated (for
 //! performance reasons) and may hence contain outdated values.
+//! All nodes and routes of a solution are stored in blocks owned by the
+//! solution. The customers are in the node arena at the index of their id,
+//! followed by two depots for each route slot. This allows copying a
+//! solution without any allocations (see copy_solution).
 struct solution {
     Route** routes;  //!< array of pointers to the solution's routes
     int trucks;  //!< the number of trucks (routes) used by the solution
@@ -29,20 +60,49 @@ struct solution {
     double dist_cache;  //!< The total distance required by this solution.
     double cost_cache;  //!< The total cost of this solution.
     Problem* pb;  //!< Pointer to the problem instance.
+    //! Random number generator for constructing and modifying the solution;
+    //! defaults to the problem's generator. It isn't copied by copy_solution.
+    Rng* rng;
+    //! Evaluator for the best moves (see move_all_best); defaults to the
+    //! problem's evaluator. Like rng, each thread has to use its own.
+    Move_Evaluator* evaluator;
+    Node* arena;  //!< Customers followed by an opening and closing depot per
+                  //!< route slot.
+    Route* route_pool;  //!< One route slot per potential route.
+    int* free_slots;  //!< Stack of the indices of unused route slots.
+    int num_free_slots;
+    struct journal journal;  //!< For undoing trial modifications.
 };
 
+//! Called for each constructed solution before its local search by the
+//! threaded metaheuristics.
+//! \return nonzero if the solution is to be discarded.
+typedef int (*Solution_Filter)(Solution* sol, void* data);
+
+//! Called with the fingerprints of the states the local search reaches (see
+//! do_ls_filtered).
+//! \return nonzero if the state is known; otherwise, it is to be recorded.
+typedef int (*State_Filter)(uint64_t state, void* data);
+
 Solution* new_solution(Problem*);
+Route* acquire_route(Solution*);
 void assert_feasibility(Solution*);
 double calc_costs(Solution* sol, const Config* cfg);
 double calc_dist(Solution*);
 int calc_workers(Solution*);
+void checkpoint_solution(Solution*);
 Solution* clone_solution(Solution*);
+void commit_solution(Solution*);
+void copy_solution(Solution* dst, const Solution* src);
 void fprint_solution(FILE* stream, Solution*, Config*, int verbose);
 void free_solution(Solution*);
 int get_route_index(Solution*, int route_id);
+uint64_t hash_solution(const Solution*);
+void journal_route(Route*);
 void remove_route(Solution*, int route_idx);
 void remove_unrouted(Solution*, Node *node);
 void reset_solution(Solution*, int num_nodes);
+void rollback_solution(Solution*);
 void save_solution_details(Solution*, Config*);
 
 
@@ -61,8 +61,8 @@ Tabulist* new_tabulist(Problem* pb) {
   // The second dimension allocates num_nodes - 1 columns => one for each
   // route given that the worst case is that every node is on a separate
   // route. The route ids start with 0 and can hence be used directly.
-  tl->nodes_routes = init_unsigned_long_matrix((size_t) pb->num_nodes,
-                                               (size_t) pb->num_nodes - 1,
+  tl->nodes_routes = init_unsigned_long_matrix((size_t) pb->inst->num_nodes,
+                                               (size_t) pb->inst->num_nodes - 1,
                                                tl->iteration);
   return tl;
 }
@@ -76,18 +76,26 @@ void free_tabulist(Tabulist* tl, size_t dim) {
 }
 
 
-//! Return 1 if the given move is tabu, otherwise 0.
-//! A move is considered tabu if any of the nodes in the move violate any
-//! tabu criterion.
-int is_move_tabu(Tabulist* tl, Move* m) {
+//! Return the iteration from which on the given move is no longer tabu.
+//! The move is tabu as long as the result is greater than tl->iteration.
+unsigned long get_tabu_expiry(const Tabulist* tl, const Move* m) {
   if (!tl->active) return 0;
-  Node* n = m->first;
+  unsigned long expiry = 0;
+  const Node* n = m->first;
   do {
-    if (tl->nodes_routes[n->id][m->target->id] > tl->iteration)
-      return 1;
+    if (tl->nodes_routes[n->id][m->target->id] > expiry)
+      expiry = tl->nodes_routes[n->id][m->target->id];
     n = n->next;
   } while (n != m->last->next);
-  return 0;
+  return expiry;
+}
+
+
+//! Return 1 if the given move is tabu, otherwise 0.
+//! A move is considered tabu if any of the nodes in the move violate any
+//! tabu criterion.
+int is_move_tabu(Tabulist* tl, Move* m) {
+  return get_tabu_expiry(tl, m) > tl->iteration;
 }
 
 
@@ -102,9 +110,12 @@ void solve_ts(Problem* pb, int workers) {
   ts_construct_routes(pb->sol, workers);
   int state = REDUCE_TRUCKS;
   double best_cost = calc_costs(pb->sol, pb->cfg);
-  Solution *sol = clone_solution(pb->sol);
+  Solution *sol = pb->sol;  // the moves since the best solution are undoable
+  Move_Evaluator* me = sol->evaluator;
+  reset_move_evaluator(me, sol);
   int updated = 0;
   Move m; init_move(&m, NON_IMPROVING);
+  checkpoint_solution(sol);
   do {
     updated = 0;
     // TODO: hack to account for trucks and workers; needs to be replaced
@@ -115,14 +126,7 @@ void solve_ts(Problem* pb, int workers) {
     if (pb->cfg->runtime &&
         ((time((time_t*) NULL) - pb->start_time) * 2 > pb->cfg->runtime))
       state = REDUCE_WORKERS;
-    for (int i = sol->trucks - 1; i >= 1; --i) {
-      for (int j = i - 1; j >= 0; --j) {
-        updated |= update_move(&m, sol->routes[j], sol->routes[i], state, 2);
-        updated |= update_move(&m, sol->routes[i], sol->routes[j], state, 2);
-        updated |= update_move(&m, sol->routes[j], sol->routes[i], state, 1);
-        updated |= update_move(&m, sol->routes[i], sol->routes[j], state, 1);
-      }
-    }
+    updated = find_best_move(me, &m, state);
     sol->workers_cache -= m.delta_workers;
     sol->dist_cache -= m.delta_dist;
     perform_move(sol, &m);
@@ -132,11 +136,11 @@ void solve_ts(Problem* pb, int workers) {
       best_cost = sol->cost_cache;
       sol->time = time((time_t *)NULL) - pb->start_time;
       print_progress(sol);
-      free_solution(pb->sol);
-      pb->sol = clone_solution(sol);
+      commit_solution(sol);
+      checkpoint_solution(sol);
     }
   } while (updated && proceed(pb, pb->tl->iteration));
-  free_solution(sol);
+  rollback_solution(sol);  // return to the best solution
 }
 
 
@@ -30,6 +30,7 @@ struct tabulist {
   unsigned long nodes_routes_tabutime;
 };
 
+unsigned long get_tabu_expiry(const Tabulist* tl, const Move* m);
 int is_move_tabu(Tabulist* tl, Move* m);
 Tabulist* new_tabulist(Problem*);
 void free_tabulist(Tabulist* tl, size_t dim);
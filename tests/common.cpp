@@ -19,8 +19,10 @@ namespace fs = boost::filesystem;
 // Platform dependent solution currently only implemented for Linux.
 std::string get_application_path() {
   char buf[PATH_MAX + 1];
-  if (readlink("/proc/self/exe", buf, sizeof(buf) - 1) == -1)
+  ssize_t len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+  if (len == -1)
     throw std::string("readlink() failed");
+  buf[len] = '\0';  // readlink does not terminate the string
   std::string str(buf);
   return str.substr(0, str.rfind('/'));
 }
@@ -43,7 +43,6 @@ public:
 TEST_F(TestCache, test_add_one) {
   Cache cache(*pb);
   solve_solomon(pb->sol, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
-  calc_costs(pb->sol, pb->cfg);
   cache.add(*(pb->sol));
   ASSERT_TRUE(cache.contains(*(pb->sol)));  // solution is in cache
   ASSERT_TRUE(cache.contains(*(pb->sol)));  // solution is in cache
@@ -57,39 +56,103 @@ TEST_F(TestCache, test_add_three) {
   solve_solomon(sol1, (int) pb->cfg->max_workers, sol1->num_unrouted);
   Solution* sol2 = clone_solution(sol1);
   Solution* sol3 = clone_solution(sol1);
-  calc_costs(sol1, pb->cfg);
-  calc_costs(sol2, pb->cfg);
-  calc_costs(sol3, pb->cfg);
-  sol2->cost_cache += 1;
-  sol3->cost_cache -= 1;
+  sol2->routes[0]->workers--;  // the hash does not check feasibility
+  int r = 0;
+  while (sol3->routes[r]->len < TWO_CUSTOMERS)  // n must not return in place
+    ++r;
+  Route* source = sol3->routes[r];
+  Route* target = sol3->routes[r ? 0 : 1];
+  Node* n = source->nodes->next;
+  remove_nodes(source, n, n);
+  add_nodes(target, n, n, target->nodes);
   cache.add(*sol1);
   cache.add(*sol2);
   cache.add(*sol3);
   ASSERT_TRUE(cache.contains(*sol1));  // solution is in cache
   ASSERT_TRUE(cache.contains(*sol2));  // solution is in cache
   ASSERT_TRUE(cache.contains(*sol3));  // solution is in cache
-  sol3->cost_cache -= 1;
+  remove_nodes(target, n, n);
+  add_nodes(source, n, n, source->tail->prev);
   ASSERT_FALSE(cache.contains(*sol3));  // modified sol3 is not in cache
   cache.add(*sol3);
-  ASSERT_EQ(4, cache.size());  // total of three different solutions
+  ASSERT_EQ(4, cache.size());  // total of four different solutions
   ASSERT_EQ(7, cache.queries());  // 4 solutions + 3 matching calls to contains
+  free_solution(sol1);
+  free_solution(sol2);
+  free_solution(sol3);
 }
 
-TEST_F(TestCache, test_hash) {
+TEST_F(TestCache, test_grow) {
   Cache cache(*pb);
-  Solution* sol_ptr = new_solution(pb);
-  solve_solomon(sol_ptr, (int) pb->cfg->max_workers, sol_ptr->num_unrouted);
-  calc_costs(sol_ptr, pb->cfg);
-//   fprint_solution(stderr, sol_ptr, pb->cfg, 1);  // TODO: remove
-  unsigned long int hash = cache.hash(*sol_ptr);
-  sol_ptr->cost_cache += 1;
-  ASSERT_NE(hash, cache.hash(*sol_ptr));
-  sol_ptr->cost_cache -= 2;
-  ASSERT_NE(hash, cache.hash(*sol_ptr));
-  sol_ptr->cost_cache += 1;
-  ASSERT_EQ(hash, cache.hash(*sol_ptr));
+  std::size_t slots = cache.m_keys.size();
+  const std::uint64_t n = 10 * slots;
+  for (std::uint64_t key = 0; key < n; ++key)
+    cache.add_key(key * 1000003);  // include key 0 and regular patterns
+  ASSERT_EQ(n, cache.size());
+  ASSERT_LT(slots, cache.m_keys.size());
+  ASSERT_LE(cache.load_factor(), 0.75);
+  ASSERT_GE(cache.memory(), 12 * cache.m_keys.size());
+  for (std::uint64_t key = 0; key < n; ++key)
+    ASSERT_EQ(2, cache.count_key(key * 1000003));
+  ASSERT_EQ(0, cache.count_key(1));
+  ASSERT_EQ(2 * n, cache.queries());  // one add and one lookup per key
+}
 
-  sol_ptr->cost_cache -= 3.5;
-  ASSERT_NE(hash, cache.hash(*sol_ptr));
+TEST_F(TestCache, test_evict) {
+  pb->cfg->cache_max_entries = 100;
+  Cache cache(*pb);
+  const std::uint64_t hot = 42;
+  cache.add_key(hot);
+  for (std::uint64_t key = 1000; key < 2000; ++key) {
+    cache.add_key(key);
+    ASSERT_TRUE(cache.count_key(hot));  // frequently hit keys are kept
+    ASSERT_LE(cache.size(), 100);
+  }
+  ASSERT_EQ(901, cache.evictions());
+  ASSERT_EQ(1000, cache.hits());
+  ASSERT_EQ(1000, cache.lookups());
+  ASSERT_TRUE(cache.count_key(1999));  // the latest key is still cached
+  std::size_t found = 0;
+  for (std::uint64_t key = 1000; key < 2000; ++key)
+    found += cache.count_key(key) > 0;
+  ASSERT_EQ(99, found);  // all remaining keys can still be found
+  Cache half(*pb, 2);  // two caches split the budget
+  for (std::uint64_t key = 0; key < 1000; ++key)
+    half.add_key(key);
+  ASSERT_EQ(50, half.size());
+  pb->cfg->cache_max_entries = 0;
+  pb->cfg->cache_max_bytes = 4096;
+  Cache small(*pb);
+  for (std::uint64_t key = 0; key < 1000; ++key)
+    small.add_key(key);
+  ASSERT_LE(small.memory(), 4096);
+  // the old table is half the size of the final one
+  ASSERT_LE(sizeof(Cache) + 3 * (small.memory() - sizeof(Cache)) / 2, 4096);
+  ASSERT_EQ(1000 - small.size(), small.evictions());
+}
 
+TEST_F(TestCache, test_hash) {
+  Cache cache(*pb);
+  Solution* sol = pb->sol;
+  solve_solomon(sol, (int) pb->cfg->max_workers, sol->num_unrouted);
+  for (int i = 0; i < sol->trucks; ++i) {  // maintained while constructing
+    uint64_t hash = 0;
+    for (Node* n = sol->routes[i]->nodes; n->next; n = n->next)
+      hash ^= arc_key(n->id, n->next->id);
+    ASSERT_EQ(hash, sol->routes[i]->hash);
+  }
+  unsigned long int hash = cache.hash(*sol);
+  std::swap(sol->routes[0], sol->routes[1]);
+  ASSERT_EQ(hash, cache.hash(*sol));  // the order of the routes is irrelevant
+  Route* route = sol->routes[0];
+  Node* n = route->nodes->next;
+  remove_nodes(route, n, n);
+  ASSERT_NE(hash, cache.hash(*sol));
+  add_nodes(route, n, n, route->nodes);
+  ASSERT_EQ(hash, cache.hash(*sol));
+  route->workers++;
+  ASSERT_NE(hash, cache.hash(*sol));
+  route->workers--;
+  sol->cost_cache += 1.0;  // the costs are irrelevant
+  ASSERT_EQ(hash, cache.hash(*sol));
 }
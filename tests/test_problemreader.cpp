@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <vector>
 
 #include "common.hpp"
 
@@ -7,9 +10,11 @@ extern "C" {
   #include "../common.h"
   #include "../config.h"
   #include "../node.h"
+  #include "../ant_colony_optimization.h"
   #include "../problemreader.h"
   #include "../route.h"
   #include "../solution.h"
+  #include "../vrptwms.h"
 }
 
 const std::string test_instance("R101_25.txt");
@@ -47,15 +52,181 @@ TEST(TestProblemreader, get_problem) {
   std::string instance_path = get_instance_path(test_instance);
   Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
   ASSERT_EQ(cfg, pb->cfg);
-  ASSERT_EQ(200, pb->capacity);
+  ASSERT_EQ(200, pb->inst->capacity);
   ASSERT_EQ(0, pb->num_solutions);
-  ASSERT_EQ(26, pb->num_nodes);
-  ASSERT_STREQ("R101_25", pb->name);
-  ASSERT_TRUE(pb->c_m);
-  ASSERT_TRUE(pb->nodes);
+  ASSERT_EQ(26, pb->inst->num_nodes);
+  ASSERT_STREQ("R101_25", pb->inst->name);
+  ASSERT_TRUE(pb->inst->c_m);
+  ASSERT_TRUE(pb->inst->nodes);
   ASSERT_TRUE(pb->pheromone);
   ASSERT_TRUE(pb->sol);
   ASSERT_TRUE(pb->tl);
+  ASSERT_TRUE(pb->owns_inst);
+  free_problem(pb);
+  free(cfg);
+}
+
+TEST(TestProblemreader, shared_instance) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  Instance* inst = get_instance((char *) instance_path.c_str(), cfg);
+  Problem* pb1 = new_problem(inst);
+  Problem* pb2 = new_problem(inst);
+  ASSERT_EQ(inst, pb1->inst);
+  ASSERT_EQ(inst, pb2->inst);
+  ASSERT_FALSE(pb1->owns_inst);
+  ASSERT_NE(pb1->pheromone, pb2->pheromone);  // separate search state
+  solve_solomon(pb1->sol, (int) cfg->max_workers, pb1->sol->num_unrouted);
+  solve_solomon(pb2->sol, (int) cfg->max_workers, pb2->sol->num_unrouted);
+  ASSERT_EQ(pb1->sol->trucks, pb2->sol->trucks);
+  ASSERT_DOUBLE_EQ(calc_costs(pb1->sol, cfg), calc_costs(pb2->sol, cfg));
+  free_problem(pb1);
+  free_problem(pb2);
+  ASSERT_EQ(26, inst->num_nodes);  // the instance outlives its problems
+  free_instance(inst);
+  free(cfg);
+}
+
+TEST(TestProblemreader, dynamic_ants) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_EQ(cfg->ants, pb->ants);
+  free_problem(pb);
+  cfg->ants = 0;
+  cfg->ants_dynamic = 1;
+  pb = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_EQ(25, pb->ants);  // one ant per customer
+  ASSERT_EQ(0, cfg->ants);  // the shared configuration is not modified
+  free_problem(pb);
+  free(cfg);
+}
+
+TEST(TestProblemreader, cost_matrix) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_EQ(0u, (uintptr_t) pb->inst->c_m % CACHE_LINE);  // aligned block
+  ASSERT_EQ(0u, pb->inst->c_m_stride * sizeof(double) % CACHE_LINE);  // rows
+  ASSERT_GE(pb->inst->c_m_stride, (size_t) pb->inst->num_nodes);
+  ASSERT_DOUBLE_EQ(0.0, get_dist(pb, 1, 1));
+  ASSERT_DOUBLE_EQ(sqrt(6.0 * 6.0 + 14.0 * 14.0), get_dist(pb, DEPOT, 1));
+  ASSERT_EQ(get_dist(pb, 1, DEPOT), get_dist_row(pb, 1)[DEPOT]);
+  for (int w = 1; w <= cfg->max_workers; ++w) {
+    ASSERT_DOUBLE_EQ(get_dist(pb, 1, 2) + pb->inst->nodes[1]->service_time / w,
+                     get_cost(pb, w, 1, 2));
+  }
+  free_problem(pb);
+  free(cfg);
+}
+
+TEST(TestProblemreader, lazy_costs) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  cfg->lazy_costs = cfg_false;
+  Problem* full = get_problem((char *) instance_path.c_str(), cfg);
+  cfg->lazy_costs = cfg_true;
+  Problem* lazy = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_FALSE(full->inst->service);
+  ASSERT_TRUE(lazy->inst->service);
+  for (int w = 0; w <= cfg->max_workers; ++w) {
+    for (int i = 0; i < full->inst->num_nodes; ++i) {
+      for (int j = 0; j < full->inst->num_nodes; ++j) {
+        if (i == j) continue;  // never used; see get_cost
+        ASSERT_EQ(get_cost(full, w, i, j), get_cost(lazy, w, i, j));
+      }
+    }
+  }
+  ASSERT_EQ(0.0, get_cost(lazy, 1, DEPOT, DEPOT));  // empty routes
+  free_problem(full);
+  free_problem(lazy);
+  free(cfg);
+}
+
+TEST(TestProblemreader, compatibility) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_FALSE(can_follow(pb, 1, 1, 2));  // 2 closes before 1 opens
+  ASSERT_TRUE(can_follow(pb, 1, 2, 1));
+  for (int w = 0; w <= cfg->max_workers; ++w) {
+    for (int i = 0; i < pb->inst->num_nodes; ++i) {
+      ASSERT_TRUE(can_follow(pb, w, DEPOT, i));
+      for (int j = 0; j < pb->inst->num_nodes; ++j) {
+        bool feasible = pb->inst->nodes[i]->est + get_cost(pb, w, i, j) <=
+                        pb->inst->nodes[j]->lst;
+        ASSERT_EQ(feasible, can_follow(pb, w, i, j));
+      }
+    }
+  }
+  free_problem(pb);
+  free(cfg);
+}
+
+TEST(TestProblemreader, neighbours) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  cfg->neighbours = 0;
+  Problem* all = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_FALSE(all->inst->neighbours);
+  ASSERT_TRUE(is_neighbour(all, 1, 2));
+  cfg->neighbours = 5;
+  Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
+  ASSERT_EQ(5, pb->inst->num_neighbours);
+  for (int i = 1; i < pb->inst->num_nodes; ++i) {
+    const int* list = pb->inst->neighbours + i * pb->inst->num_neighbours;
+    int count = 0;
+    for (int j = 0; j < pb->inst->num_nodes; ++j)
+      count += is_neighbour(pb, i, j);
+    ASSERT_TRUE(is_neighbour(pb, i, DEPOT));
+    ASSERT_FALSE(is_neighbour(pb, i, i));
+    ASSERT_LE(count, 1 + pb->inst->num_neighbours);
+    for (int l = 0; l < pb->inst->num_neighbours; ++l) {
+      ASSERT_TRUE(is_neighbour(pb, i, list[l]));
+      if (l && list[l]) {
+        ASSERT_LE(get_dist(pb, i, list[l - 1]), get_dist(pb, i, list[l]));
+      }
+    }
+  }
+  free_problem(all);
+  free_problem(pb);
+  free(cfg);
+}
+
+TEST(TestProblemreader, lazy_evaporation) {
+  std::string config_path = get_config_path(config_file);
+  Config* cfg = get_config((char *) config_path.c_str());
+  std::string instance_path = get_instance_path(test_instance);
+  cfg->rho = 0.01;  // force renormalizing the stored values
+  Problem* pb = get_problem((char *) instance_path.c_str(), cfg);
+  solve_solomon(pb->sol, (int) cfg->max_workers, pb->sol->num_unrouted);
+  int dim = 2 * pb->inst->num_nodes - 1;
+  std::vector<double> eager((size_t) (dim * dim), cfg->initial_pheromone);
+  for (int k = 0; k < 60; ++k) {
+    update_pheromone(pb, pb->sol);
+    for (size_t i = 0; i < eager.size(); ++i)  // the former, eager update
+      eager[i] = fmax(eager[i] * cfg->rho, cfg->min_pheromone);
+    for (int r = 0; r < pb->sol->trucks; ++r) {
+      Route* route = pb->sol->routes[r];
+      for (Node* n = route->nodes; n->next; n = n->next) {
+        int i = n->id ? n->id : pb->inst->num_nodes + r;
+        int j = n->next->id ? n->next->id : pb->inst->num_nodes + r;
+        eager[(size_t) (i * dim + j)] += 1.0 - cfg->rho;
+      }
+    }
+  }
+  for (int i = 1; i < dim; ++i) {
+    for (int j = 1; j < dim; ++j) {
+      ASSERT_DOUBLE_EQ(eager[(size_t) (i * dim + j)],
+                       get_pheromone(pb, i, j));
+    }
+  }
   free_problem(pb);
   free(cfg);
 }
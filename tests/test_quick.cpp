@@ -6,6 +6,7 @@
 #include <gtest/gtest.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <set>
 
 #include "common.hpp"
 
@@ -14,6 +15,7 @@ extern "C" {
   #include "../common.h"
   #include "../config.h"
   #include "../grasp.h"
+  #include "../local_search.h"
   #include "../node.h"
   #include "../problemreader.h"
   #include "../route.h"
@@ -77,7 +79,7 @@ TEST_F(QuickTest, stochastic_solomon) {
 
 TEST_F(QuickTest, run_aco_parallel) {
   pb->cfg->metaheuristic = ACO;
-  pb->cfg->ants = 50;
+  pb->ants = 50;
   pb->cfg->start_heuristic = PARALLEL;
   solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
   assert_feasibility(pb->sol);
@@ -85,7 +87,7 @@ TEST_F(QuickTest, run_aco_parallel) {
 
 TEST_F(QuickTest, run_aco) {
   pb->cfg->metaheuristic = ACO;
-  pb->cfg->ants = 50;
+  pb->ants = 50;
   pb->cfg->start_heuristic = SOLOMON;
   solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
   assert_feasibility(pb->sol);
@@ -93,13 +95,33 @@ TEST_F(QuickTest, run_aco) {
 
 TEST_F(QuickTest, run_aco_ls) {
   pb->cfg->metaheuristic = ACO;
-  pb->cfg->ants = 50;
+  pb->ants = 50;
   pb->cfg->do_ls = (cfg_bool_t) 1;
   pb->cfg->start_heuristic = SOLOMON;
   solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
   assert_feasibility(pb->sol);
 }
 
+TEST_F(QuickTest, run_aco_threads) {
+  pb->cfg->metaheuristic = ACO;
+  pb->ants = 50;
+  pb->cfg->do_ls = (cfg_bool_t) 1;
+  pb->cfg->start_heuristic = SOLOMON;
+  pb->cfg->threads = 4;
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  assert_feasibility(pb->sol);
+  ASSERT_EQ(100, pb->num_solutions);  // two generations of ants
+}
+
+TEST_F(QuickTest, run_cached_aco_threads) {
+  pb->cfg->metaheuristic = CACHED_ACO;
+  pb->ants = 50;
+  pb->cfg->start_heuristic = PARALLEL;
+  pb->cfg->threads = 3;
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  assert_feasibility(pb->sol);
+}
+
 TEST_F(QuickTest, run_ts) {
   pb->tl->active = 1;  // required as the problem was initialized w/ ACO
   pb->cfg->metaheuristic = TS;
@@ -126,6 +148,18 @@ TEST_F(QuickTest, run_grasp_weighted) {
   assert_feasibility(pb->sol);
 }
 
+TEST_F(QuickTest, run_grasp_threads) {
+  pb->cfg->metaheuristic = GRASP;
+  pb->cfg->start_heuristic = SOLOMON;
+  pb->cfg->do_ls = (cfg_bool_t) 1;
+  pb->cfg->threads = 4;
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  assert_feasibility(pb->sol);
+  ASSERT_EQ(pb->cfg->max_iterations, pb->num_solutions);
+  ASSERT_EQ(&pb->rng, pb->sol->rng);
+  ASSERT_EQ(pb->evaluator, pb->sol->evaluator);
+}
+
 TEST_F(QuickTest, run_vns) {
   pb->cfg->metaheuristic = VNS;
   pb->cfg->start_heuristic = SOLOMON;
@@ -133,3 +167,87 @@ TEST_F(QuickTest, run_vns) {
     assert_feasibility(pb->sol);
 }
 
+
+TEST_F(QuickTest, run_grasp_ls_threads) {
+  pb->cfg->metaheuristic = GRASP;
+  pb->cfg->start_heuristic = SOLOMON;
+  pb->cfg->do_ls = (cfg_bool_t) 1;
+  pb->cfg->max_iterations = 10;
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  pb->cfg->ls_threads = 3;  // the evaluator is created with the problem
+  Problem* parallel = new_problem(pb->inst);
+  solve(parallel, (int) pb->cfg->max_workers, parallel->sol->num_unrouted);
+  assert_feasibility(parallel->sol);
+  ASSERT_EQ(pb->sol->trucks, parallel->sol->trucks);  // same moves performed
+  ASSERT_EQ(calc_costs(pb->sol, pb->cfg), calc_costs(parallel->sol, pb->cfg));
+  free_problem(parallel);
+}
+
+TEST_F(QuickTest, run_ts_ls_threads) {
+  pb->tl->active = 1;  // required as the problem was initialized w/ ACO
+  pb->cfg->metaheuristic = TS;
+  pb->cfg->start_heuristic = SOLOMON;
+  solve(pb, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  pb->cfg->ls_threads = 4;
+  Problem* parallel = new_problem(pb->inst);
+  parallel->tl->active = 1;
+  solve(parallel, (int) pb->cfg->max_workers, parallel->sol->num_unrouted);
+  assert_feasibility(parallel->sol);
+  ASSERT_EQ(pb->tl->iteration, parallel->tl->iteration);
+  ASSERT_EQ(calc_costs(pb->sol, pb->cfg), calc_costs(parallel->sol, pb->cfg));
+  free_problem(parallel);
+}
+
+TEST_F(QuickTest, tabu_expiry) {
+  pb->tl->active = 1;
+  solve_solomon(pb->sol, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  Route* source = pb->sol->routes[0];
+  Route* target = pb->sol->routes[1];
+  Move m; init_move(&m, IMPROVING);
+  m.source = source;
+  m.target = target;
+  m.first = m.last = source->nodes->next;
+  ASSERT_EQ(0u, get_tabu_expiry(pb->tl, &m));
+  update_tabulist_move(pb->tl, &m);  // forbids moving the node back to source
+  Move back = m;
+  back.source = target;
+  back.target = source;
+  unsigned long expiry = pb->tl->iteration + pb->tl->nodes_routes_tabutime;
+  ASSERT_EQ(expiry, get_tabu_expiry(pb->tl, &back));
+  ASSERT_TRUE(is_move_tabu(pb->tl, &back));
+  pb->tl->iteration = expiry;
+  ASSERT_FALSE(is_move_tabu(pb->tl, &back));
+}
+
+TEST_F(QuickTest, reduce_distance) {
+  solve_solomon(pb->sol, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  int trucks = pb->sol->trucks;
+  int workers = calc_workers(pb->sol);
+  double dist = calc_dist(pb->sol);
+  ASSERT_TRUE(reduce_distance(pb->sol));
+  assert_feasibility(pb->sol);
+  ASSERT_EQ(trucks, pb->sol->trucks);
+  ASSERT_GE(workers, calc_workers(pb->sol));
+  ASSERT_GT(dist, calc_dist(pb->sol));
+  ASSERT_FALSE(reduce_distance(pb->sol));  // a local optimum
+  pb->cfg->max_optimize = 0;
+  ASSERT_FALSE(reduce_distance(pb->sol));
+}
+
+//! Record the given state; return nonzero if it was already recorded.
+static int known_state(uint64_t state, void* data) {
+  std::set<uint64_t>* states = static_cast<std::set<uint64_t>*>(data);
+  return !states->insert(state).second;
+}
+
+TEST_F(QuickTest, do_ls_filtered) {
+  pb->cfg->do_ls = (cfg_bool_t) 1;
+  solve_solomon(pb->sol, (int) pb->cfg->max_workers, pb->sol->num_unrouted);
+  Solution* copy = clone_solution(pb->sol);
+  std::set<uint64_t> states;
+  ASSERT_EQ(0, do_ls_filtered(pb->sol, known_state, &states));
+  assert_feasibility(pb->sol);
+  ASSERT_FALSE(states.empty());
+  ASSERT_EQ(1, do_ls_filtered(copy, known_state, &states));  // same descent
+  free_solution(copy);
+}
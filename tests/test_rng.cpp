@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+extern "C" {
+  #include "../common.h"
+  #include "../rng.h"
+}
+
+TEST(TestRng, reference_output) {
+  Rng rng = {{1, 2, 3, 4}};  // output of the reference implementation
+  ASSERT_EQ(UINT64_C(11520), next_rng(&rng));
+  ASSERT_EQ(UINT64_C(0), next_rng(&rng));
+  ASSERT_EQ(UINT64_C(1509978240), next_rng(&rng));
+  ASSERT_EQ(UINT64_C(1215971899390074240), next_rng(&rng));
+}
+
+TEST(TestRng, seed_rng) {
+  Rng first, second;
+  seed_rng(&first, 4711);
+  seed_rng(&second, 4711);
+  for (int i = 0; i < 1000; ++i) {
+    double x = rand_uniform(&first);
+    ASSERT_EQ(x, rand_uniform(&second));
+    ASSERT_GE(x, 0.0);
+    ASSERT_LT(x, 1.0);
+    ASSERT_GE(rand_long(&first), 0);
+    rand_long(&second);
+  }
+  seed_rng(&second, 4712);
+  ASSERT_NE(next_rng(&first), next_rng(&second));
+}
+
+TEST(TestRng, jump_rng) {
+  Rng rng, stream;
+  seed_rng(&rng, 42);
+  stream = rng;
+  jump_rng(&stream);
+  ASSERT_NE(next_rng(&rng), next_rng(&stream));
+}
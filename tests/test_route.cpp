@@ -10,6 +10,7 @@ extern "C" {
   #include "../problemreader.h"
   #include "../route.h"
   #include "../solution.h"
+  #include "../vrptwms.h"
 }
 
 const std::string test_instance("R101.txt");
@@ -48,3 +49,195 @@ TEST_F(TestRoute, test_new_route) {
   ASSERT_EQ(DEPOT, r->tail->id);  // end w/ depot
 }
 
+
+//! Assert that the route's arrays mirror its list of nodes.
+static void assert_arrays_match_list(Route* r) {
+  Node* n = r->nodes;
+  int i = 0;
+  for (; n; ++i, n = n->next) {
+    ASSERT_EQ(n, r->arr.nodes[i]);
+    ASSERT_EQ(n->id, r->arr.ids[i]);
+    ASSERT_EQ(n->demand, r->arr.demand[i]);
+    if (n->next) {  // aest is not maintained for the closing depot
+      ASSERT_EQ(n->aest, r->arr.aest[i]);
+    }
+    if (n->prev) {  // alst is not maintained for the opening depot
+      ASSERT_EQ(n->alst, r->arr.alst[i]);
+    }
+  }
+  ASSERT_EQ(r->len, i);
+}
+
+TEST_F(TestRoute, test_route_arrays) {
+  Solution* sol = pb->sol;
+  int workers = (int) pb->cfg->max_workers;
+  Node* seed = sol->unrouted;
+  remove_unrouted(sol, seed);
+  Route* r = new_route(sol, seed, workers);
+  assert_arrays_match_list(r);
+  // grow the route beyond the arrays' initial capacity
+  while (sol->unrouted && r->len < 40) {
+    Node* n = sol->unrouted;
+    remove_unrouted(sol, n);
+    add_nodes(r, n, n, r->tail->prev);
+  }
+  assert_arrays_match_list(r);
+  ASSERT_EQ(get_position(r, r->tail), r->len - 1);
+  Node* first = r->nodes->next->next;
+  Node* last = first->next->next;
+  remove_nodes(r, first, last);
+  assert_arrays_match_list(r);
+  add_nodes(r, first, last, r->nodes);
+  assert_arrays_match_list(r);
+  ASSERT_EQ(first, r->arr.nodes[1]);
+  Solution* clone = clone_solution(sol);
+  Route* copy = clone->routes[clone->trucks - 1];
+  assert_arrays_match_list(copy);
+  ASSERT_DOUBLE_EQ(calc_length(r), calc_length(copy));
+  for (Node* n = copy->nodes; n; n = n->next) {  // nodes are not shared
+    ASSERT_TRUE(n >= clone->arena &&
+                n < clone->arena + 3 * pb->inst->num_nodes);
+  }
+  free_solution(clone);
+}
+
+TEST_F(TestRoute, test_segments) {
+  Solution* sol = pb->sol;
+  solve_solomon(sol, (int) pb->cfg->max_workers, sol->num_unrouted);
+  for (int r = 0; r < sol->trucks; ++r) {
+    Route* route = sol->routes[r];
+    update_segments(route);
+    ASSERT_TRUE(route->arr.segments_valid);
+    int last = route->len - 1;
+    for (int i = 0; i < last; ++i) {  // the prefixes yield the aests
+      const Segment* s = get_prefix(route, route->workers, i);
+      ASSERT_TRUE(s->feasible);
+      ASSERT_DOUBLE_EQ(route->arr.aest[i], s->earliest + s->duration);
+    }
+    for (int w = 1; w <= pb->cfg->max_workers; ++w) {
+      bool feasible = is_feasible_with(route, w);
+      ASSERT_EQ(feasible, get_prefix(route, w, last)->feasible);
+      ASSERT_EQ(feasible, get_suffix(route, w, 0)->feasible);
+      const Segment* all = get_prefix(route, w, last);
+      ASSERT_DOUBLE_EQ(route->load, all->load);
+    }
+    Node* n = route->nodes->next;
+    remove_nodes(route, n, n);
+    ASSERT_FALSE(route->arr.segments_valid);  // recalculated on demand
+    add_nodes(route, n, n, route->nodes);
+  }
+}
+
+
+TEST_F(TestRoute, test_min_workers) {
+  Solution* sol = pb->sol;
+  solve_solomon(sol, (int) pb->cfg->max_workers, sol->num_unrouted);
+  for (int r = 0; r < sol->trucks; ++r) {
+    Route* route = sol->routes[r];
+    int min_workers = get_min_workers(route);
+    ASSERT_EQ(min_workers, route->arr.min_workers);  // cached
+    for (int w = 1; w < route->workers; ++w) {  // the former linear scan
+      ASSERT_EQ(w >= min_workers, (bool) is_feasible_with(route, w));
+    }
+    bool reducible = min_workers < route->workers;
+    ASSERT_EQ(reducible, (bool) reduce_service_workers(route));
+    ASSERT_EQ(min_workers, route->workers);
+    ASSERT_TRUE(is_feasible(route));
+    Node* n = route->nodes->next;
+    remove_nodes(route, n, n);
+    ASSERT_EQ(0, route->arr.min_workers);  // recalculated on demand
+    add_nodes(route, n, n, route->nodes);
+  }
+}
+
+
+TEST_F(TestRoute, test_dirty) {
+  Solution* sol = pb->sol;
+  solve_solomon(sol, (int) pb->cfg->max_workers, sol->num_unrouted);
+  Route* r1 = sol->routes[0];
+  Route* r2 = sol->routes[1];
+  ASSERT_TRUE(r1->dirty);  // new routes need to be evaluated
+  r1->dirty = r2->dirty = false;
+  Node* n = r1->nodes->next;
+  remove_nodes(r1, n, n);
+  ASSERT_TRUE(r1->dirty);
+  ASSERT_FALSE(r2->dirty);
+  add_nodes(r2, n, n, r2->nodes);
+  ASSERT_TRUE(r2->dirty);
+  r1->dirty = r2->dirty = false;
+  Node* n1 = r1->nodes->next;
+  Node* n2 = r2->nodes->next;
+  n1->aest_cache = n1->aest;  // feasibility is irrelevant here
+  n2->aest_cache = n2->aest;
+  n1->next->aest_cache = n1->next->aest;
+  n2->next->aest_cache = n2->next->aest;
+  swap(r1, r2, n1, n2);
+  ASSERT_TRUE(r1->dirty);
+  ASSERT_TRUE(r2->dirty);
+}
+
+
+TEST_F(TestRoute, test_journal) {
+  Solution* sol = pb->sol;
+  solve_solomon(sol, (int) pb->cfg->max_workers, sol->num_unrouted);
+  Solution* orig = clone_solution(sol);
+  int trucks = sol->trucks;
+  checkpoint_solution(sol);
+  Route* source = sol->routes[0];
+  Route* target = sol->routes[1];
+  while (source->len > EMPTY) {  // feasibility is irrelevant here
+    Node* n = source->nodes->next;
+    remove_nodes(source, n, n);
+    add_nodes(target, n, n, target->nodes);
+  }
+  remove_route(sol, 0);
+  reduce_service_workers(sol->routes[sol->trucks - 1]);
+  ASSERT_EQ(trucks - 1, sol->trucks);
+  rollback_solution(sol);
+  ASSERT_EQ(trucks, sol->trucks);
+  ASSERT_EQ(source, sol->routes[0]);
+  for (int r = 0; r < trucks; ++r) {
+    Route* route = sol->routes[r];
+    Route* copy = orig->routes[r];
+    ASSERT_EQ(copy->len, route->len);
+    ASSERT_EQ(copy->workers, route->workers);
+    ASSERT_EQ(copy->load, route->load);
+    assert_arrays_match_list(route);
+    for (int i = 0; i < route->len; ++i) {
+      ASSERT_EQ(copy->arr.ids[i], route->arr.ids[i]);
+      ASSERT_EQ(copy->arr.aest[i], route->arr.aest[i]);
+      ASSERT_EQ(copy->arr.alst[i], route->arr.alst[i]);
+    }
+  }
+  assert_feasibility(sol);
+  checkpoint_solution(sol);
+  Node* n = source->nodes->next;
+  remove_nodes(source, n, n);
+  add_nodes(target, n, n, target->nodes);
+  commit_solution(sol);  // keeps the move
+  ASSERT_EQ(n, target->nodes->next);
+  free_solution(orig);
+}
+
+
+TEST(InsertionList, test_update_insertion_list) {
+  Insertion_List il;
+  Rng rng;
+  seed_rng(&rng, 0);
+  init_insertion_list(&il, 3, 10);
+  double attract[] = {1.0, 3.0, 2.0, 3.0, 0.5, 2.5};
+  int inserted[] = {1, 1, 1, 1, 0, 1};
+  for (int i = 0; i < 6; ++i) {
+    Insertion ins = {NULL, NULL, NULL, (double) i, attract[i], NULL, NULL};
+    ASSERT_EQ(inserted[i], update_insertion_list(&il, &ins));
+  }
+  ASSERT_EQ(3, il.size);
+  ASSERT_EQ(1.0, il.items[0].cost);  // equal attractiveness keeps the order
+  ASSERT_EQ(3.0, il.items[1].cost);
+  ASSERT_EQ(5.0, il.items[2].cost);
+  Insertion* picked = pick_insertion(&il, USE_WEIGHTS, &rng);
+  ASSERT_TRUE(picked >= il.items && picked < il.items + il.size);
+  reset_insertion_list(&il);
+  ASSERT_TRUE(pick_insertion(&il, USE_WEIGHTS, &rng) == NULL);
+  free_insertion_list(&il);
+}
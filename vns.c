@@ -5,6 +5,7 @@
  *
  */
 
+#include <math.h>
 #include <stdlib.h>
 
 #include "common.h"
@@ -12,6 +13,7 @@
 #include "local_search.h"
 #include "node.h"
 #include "problemreader.h"
+#include "rng.h"
 #include "route.h"
 #include "solution.h"
 #include "vrptwms.h"
@@ -98,17 +100,18 @@ static void improve_solution(Solution* sol) {
 //! all routes are reset to the maximum number of workers.
 static void shake_solution(Solution* sol) {
   for (int i = 0; i < sol->trucks; ++i) {
+    journal_route(sol->routes[i]);
     sol->routes[i]->workers = (int) sol->pb->cfg->max_workers;
   }
-  // skew is not a practical issue as sol->trucks is much smaller than 2^31
+  // skew is not a practical issue as sol->trucks is much smaller than 2^63
   // see http://stackoverflow.com/a/2999130/104659
-  int route_index = (int) (lrand48() % sol->trucks);
+  int route_index = (int) (rand_long(sol->rng) % sol->trucks);
   // TODO: the loop below is potentially infinite (in the unlikely event that
   // no possible moves are left); catch this and allow for another shake
   // TODO: rem 1
 //   print_route(stdout, sol->routes[route_index]);
   while(!distribute_nodes(sol, route_index)) {
-    route_index = (int) (lrand48() % sol->trucks);
+    route_index = (int) (rand_long(sol->rng) % sol->trucks);
   }
   // TODO: rem 1
 //   print_route(stdout, sol->routes[route_index]);
@@ -129,7 +132,8 @@ void solve_vns(Problem* pb, int workers) {
   pb->sol = do_ls(pb->sol);
   double cost = calc_costs(pb->sol, pb->cfg);
   double best_cost = cost;
-  Solution* sol = clone_solution(pb->sol);
+  Solution* sol = pb->sol;  // the changes since the best solution are undoable
+  checkpoint_solution(sol);
   while (proceed(pb, (unsigned long) pb->num_solutions)) {
     shake_solution(sol);
     improve_solution(sol);
@@ -143,11 +147,11 @@ void solve_vns(Problem* pb, int workers) {
       best_cost = cost;
       sol->time = time((time_t *)NULL) - pb->start_time;
       print_progress(sol);
-      free_solution(pb->sol);
-      pb->sol = clone_solution(sol);
+      commit_solution(sol);
+      checkpoint_solution(sol);
     }
     pb->num_solutions++;
   }
-  free_solution(sol);
+  rollback_solution(sol);  // return to the best solution
 }
 
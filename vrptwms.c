@@ -50,6 +50,7 @@
 #include "local_search.h"
 #include "node.h"
 #include "problemreader.h"
+#include "rng.h"
 #include "route.h"
 #include "solution.h"
 #include "stats.h"
@@ -64,16 +65,17 @@ extern void c_solve_cached_grasp(Problem* pb, int workers);
 ///////////////////////////////////////////////////////////////////////////////
 // File Scope (Static) Functions                                             //
 ///////////////////////////////////////////////////////////////////////////////
-static Node* get_best_seed(Node* unrouted, double **c_m);
+static Node* get_best_seed(Node* unrouted, const Problem* pb);
 
 //! Return the best sequential seed (which is the furthest from the depot).
 //! \return best seed or NULL if there are no more candidates available
-static Node* get_best_seed(Node* unrouted, double **c_m) {
+static Node* get_best_seed(Node* unrouted, const Problem* pb) {
+  const double *d = get_dist_row(pb, DEPOT);  // dist. from depot
   Node *best_cand = NULL;
   double max_dist = -1.0;
   while (unrouted) {
-    if (c_m[0][unrouted->id] > max_dist) {
-      max_dist = c_m[0][unrouted->id];
+    if (d[unrouted->id] > max_dist) {
+      max_dist = d[unrouted->id];
       best_cand = unrouted;
     }
     unrouted = unrouted->next;
@@ -91,7 +93,7 @@ Resultlist* add_result(Problem* pb) {
   int workers = 0;
   double dist = 0.0;
   Resultlist* result = (Resultlist*) s_malloc(sizeof(Resultlist));
-  result->name = get_name(pb->name);
+  result->name = get_name(pb->inst->name);
   result->trucks = pb->sol->trucks;
   result->time = pb->sol->time;
   result->saturation_time = pb->sol->saturation_time;
@@ -128,28 +130,28 @@ void free_results(Resultlist *results) {
 //! potential seed is taken into account - not the pheromone between the seed
 //! and all depots. This may be considered a feature or an issue.
 Node* get_seed(Solution* sol) {
-  double *d = sol->pb->c_m[0][DEPOT];  // dist. from depot
+  const double *d = get_dist_row(sol->pb, DEPOT);  // dist. from depot
   Node *nl = sol->unrouted;
   double cum_attractiveness = 0.0;
-  double **p_m = sol->pb->pheromone;
+  const Problem *pb = sol->pb;
   double trail[sol->num_unrouted];
   double* trail_ptr = trail;
-  int num_nodes = sol->pb->num_nodes;
+  int depot_id = sol->pb->inst->num_nodes + sol->trucks;
 #ifdef DEBUG
   if (sol->pb->cfg->verbosity >= FULL_DEBUG)
     printf("seed selection\n");
 #endif
   while (nl) {
     // trail denominator is the same for all nodes => no div. needed
-    (*trail_ptr) = (p_m[num_nodes + sol->trucks][nl->id] +
-                    p_m[nl->id][num_nodes + sol->trucks]);
+    (*trail_ptr) = (get_pheromone(pb, depot_id, nl->id) +
+                    get_pheromone(pb, nl->id, depot_id));
     cum_attractiveness += d[nl->id] * (*trail_ptr);
     ++trail_ptr;
     nl = nl->next;
   }
   nl = sol->unrouted;
   trail_ptr -= sol->num_unrouted;
-  double threshold = drand48() * cum_attractiveness;
+  double threshold = rand_uniform(sol->rng) * cum_attractiveness;
   while (nl) {
     cum_attractiveness -= d[nl->id] * (*trail_ptr);
     if (threshold >= cum_attractiveness) {
@@ -324,12 +326,12 @@ int solve_solomon(Solution* sol, int workers, int fleetsize) {
   }
   if (pb->cfg->verbosity >= BASIC_DEBUG) {
     printf ("depot: ");
-    print_node(pb->nodes[0]);
+    print_node(pb->inst->nodes[0]);
   }
   while (sol->unrouted) {
     if (sol->trucks == fleetsize) return sol->num_unrouted;
     if (pb->cfg->deterministic)
-      unrouted = get_best_seed(sol->unrouted, pb->c_m[0]);
+      unrouted = get_best_seed(sol->unrouted, pb);
     else
       unrouted = get_seed(sol);
     #ifdef DEBUG
@@ -360,7 +362,8 @@ int solve_solomon(Solution* sol, int workers, int fleetsize) {
         if (isinf(min_cost))
           break;
         // TODO: change this to use public function from route.{c,h}
-        ins = *aco_pick_insertion(insertions, sol->num_unrouted, min_cost);
+        ins = *aco_pick_insertion(insertions, sol->num_unrouted, min_cost,
+                                  sol->rng);
       }
       #ifdef DEBUG
       if (pb->cfg->verbosity >= BASIC_DEBUG) {
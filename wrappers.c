@@ -15,3 +15,17 @@ void *safe_malloc_(size_t size, const char *filename, int line)
   }
   return ptr;
 }
+
+void *safe_aligned_malloc_(size_t alignment, size_t size,
+                           const char *filename, int line)
+{
+  void *ptr = NULL;
+
+  if (posix_memalign(&ptr, alignment, size))
+  {
+    fprintf(stderr, "posix_memalign %lu bytes failed at %s:%d\n",
+                    (unsigned long)size, filename, line);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
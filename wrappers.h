@@ -11,7 +11,11 @@
 #include <stdlib.h>
 
 #define s_malloc(size) safe_malloc_ (size, __FILE__, __LINE__)
+#define s_aligned_malloc(alignment, size) \
+  safe_aligned_malloc_ (alignment, size, __FILE__, __LINE__)
 
 void *safe_malloc_(size_t size, const char* filename, int line);
+void *safe_aligned_malloc_(size_t alignment, size_t size,
+                           const char* filename, int line);
 
 #endif